@@ -0,0 +1,205 @@
+#ifndef AFINA_KEY_HASH_H
+#define AFINA_KEY_HASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace Afina {
+
+/**
+ * # Hash of keys
+ * Hash is wyhash: 64-bit non-cryptographic hash doing one 64x64->128 multiplication per 16 bytes
+ * of the key, which makes it several times faster than std::hash for keys of tens of bytes while
+ * passing SMHasher. Result is the same on every run and every machine of the same byte order, so
+ * it could be kept in files and shared memory.
+ *
+ * Hash is the part of Storage contract: methods taking prehashed key expect exactly this function
+ * of the key bytes, so it is computed once by the protocol layer and reused by every storage layer.
+ *
+ * Class is usable as the hasher of std containers
+ */
+class KeyHash {
+public:
+    std::size_t operator()(const std::string &key) const { return Compute(key.data(), key.size()); }
+
+    static uint64_t Compute(const void *data, std::size_t size, uint64_t seed = 0) {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        seed ^= Mix(seed ^ kSecret0, kSecret1);
+
+        uint64_t a, b;
+        if (size <= 16) {
+            if (size >= 4) {
+                // Two overlapping pairs of 32-bit words cover any size from 4 to 16
+                std::size_t shift = (size >> 3) << 2;
+                a = (Read4(p) << 32) | Read4(p + shift);
+                b = (Read4(p + size - 4) << 32) | Read4(p + size - 4 - shift);
+            } else if (size > 0) {
+                a = (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+            return Final(a, b, seed, size);
+        }
+
+        std::size_t left = size;
+        if (left > 48) {
+            // Three independent lanes keep multiplier busy on long keys
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                Lanes(p, seed, see1, see2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= see1 ^ see2;
+        }
+        return Tail(p, left, seed, size);
+    }
+
+    /**
+     * # Incremental hash
+     * Gives the same result as Compute for the key which comes in pieces, so that the key is hashed
+     * while its bytes are read. Only the part of the key which could turn out to be the last 48 bytes
+     * is buffered, everything before it is hashed right away
+     */
+    class Stream {
+    public:
+        explicit Stream(uint64_t seed = 0) { Reset(seed); }
+
+        /**
+         * Starts hashing the new key
+         */
+        void Reset(uint64_t seed = 0) {
+            _origin = seed;
+            _size = 0;
+            _pending = 0;
+            _lanes = false;
+        }
+
+        /**
+         * Hashes the next piece of the key
+         */
+        void Update(const void *data, std::size_t size) {
+            const uint8_t *p = static_cast<const uint8_t *>(data);
+            _size += size;
+            while (size > 0) {
+                std::size_t n = std::min(size, kPendingSize - _pending);
+                std::memcpy(_buffer + kHistory + _pending, p, n);
+                _pending += n;
+                p += n;
+                size -= n;
+
+                // There are bytes after the block, so it isn't the tail
+                if (_pending > 48) {
+                    if (!_lanes) {
+                        _seed = _origin ^ Mix(_origin ^ kSecret0, kSecret1);
+                        _see1 = _see2 = _seed;
+                        _lanes = true;
+                    }
+                    Lanes(_buffer + kHistory, _seed, _see1, _see2);
+
+                    // Last bytes of the block stay in front, the tail may overlap them
+                    _pending -= 48;
+                    std::memmove(_buffer, _buffer + 48, kHistory + _pending);
+                }
+            }
+        }
+
+        /**
+         * Hash of the bytes given since the last Reset
+         */
+        uint64_t Finish() const {
+            if (!_lanes) {
+                return Compute(_buffer + kHistory, _size, _origin);
+            }
+            return Tail(_buffer + kHistory, _pending, _seed ^ _see1 ^ _see2, _size);
+        }
+
+    private:
+        // Bytes kept in front of pending ones, tail of the key reads up to 16 bytes back
+        static constexpr std::size_t kHistory = 16;
+
+        // Pending bytes, up to the block and its successor
+        static constexpr std::size_t kPendingSize = 64;
+
+        uint8_t _buffer[kHistory + kPendingSize];
+        std::size_t _pending;
+        std::size_t _size;
+
+        uint64_t _origin;
+        uint64_t _seed, _see1, _see2;
+        bool _lanes;
+    };
+
+private:
+    static constexpr uint64_t kSecret0 = 0x2d358dccaa6c78a5ull;
+    static constexpr uint64_t kSecret1 = 0x8bb84b93962eacc9ull;
+    static constexpr uint64_t kSecret2 = 0x4b33a62ed433d4a3ull;
+    static constexpr uint64_t kSecret3 = 0x4d5a2da51de1aa47ull;
+
+    // Mixes 48 bytes into three lanes
+    static void Lanes(const uint8_t *p, uint64_t &seed, uint64_t &see1, uint64_t &see2) {
+        seed = Mix(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+        see1 = Mix(Read8(p + 16) ^ kSecret2, Read8(p + 24) ^ see1);
+        see2 = Mix(Read8(p + 32) ^ kSecret3, Read8(p + 40) ^ see2);
+    }
+
+    // Hashes the rest of the key longer than 16 bytes, last 16 bytes are read at p + left - 16 even if
+    // that is before p
+    static uint64_t Tail(const uint8_t *p, std::size_t left, uint64_t seed, std::size_t size) {
+        for (; left > 16; left -= 16, p += 16) {
+            seed = Mix(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+        }
+        return Final(Read8(p + left - 16), Read8(p + left - 8), seed, size);
+    }
+
+    // Mixes last 16 bytes of the key and its size into the result
+    static uint64_t Final(uint64_t a, uint64_t b, uint64_t seed, std::size_t size) {
+        a ^= kSecret1;
+        b ^= seed;
+        Multiply(a, b);
+        return Mix(a ^ kSecret0 ^ size, b ^ kSecret1);
+    }
+
+    // Replaces a and b with the low and high halves of their product
+    static void Multiply(uint64_t &a, uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = a;
+        r *= b;
+        a = static_cast<uint64_t>(r);
+        b = static_cast<uint64_t>(r >> 64);
+#else
+        uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+        uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+        uint64_t c = t < rl;
+        uint64_t lo = t + (rm1 << 32);
+        c += lo < t;
+        a = lo;
+        b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+    }
+
+    static uint64_t Mix(uint64_t a, uint64_t b) {
+        Multiply(a, b);
+        return a ^ b;
+    }
+
+    static uint64_t Read8(const uint8_t *p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint64_t Read4(const uint8_t *p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+};
+
+} // namespace Afina
+
+#endif // AFINA_KEY_HASH_H
@@ -1,7 +1,16 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
 
 namespace Afina {
 
@@ -84,6 +93,162 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Same as Get, but value comes as the sequence of pieces which may share memory with the storage
+     * instead of being copied. Pieces never change, so caller could hold them as long as it needs,
+     * e.g until those are written to the socket
+     *
+     * @param key to retrive value for
+     * @param chunks output parameter to append pieces of the value to
+     */
+    virtual bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) {
+        std::string value;
+        if (!Get(key, value)) {
+            return false;
+        }
+        chunks.emplace_back(new std::string(std::move(value)));
+        return true;
+    }
+
+    /**
+     * Appends data to the value of existing association
+     * If requested key doesn't present in storage method returns false and doesnt change anything.
+     *
+     * Default implementation reads value and sets it back extended, so it copies the whole value and
+     * isn't atomic. Storages keeping large values in chunks only add data to the last ones
+     *
+     * @param key to append data for
+     * @param data to append to the value
+     */
+    virtual bool Append(const std::string &key, const std::string &data) {
+        std::string value;
+        if (!Get(key, value)) {
+            return false;
+        }
+        return Set(key, value + data);
+    }
+
+    /**
+     * Same methods for the key which hash is computed already, so that storage layers don't hash the
+     * key again. Hash must be KeyHash::Compute of the key bytes, see afina/KeyHash.h, protocol parser
+     * computes it while reading the command. Storages which don't index keys by that hash just drop it
+     *
+     * @param hash of the key
+     */
+    virtual bool Put(const std::string &key, uint64_t hash, const std::string &value) { return Put(key, value); }
+
+    virtual bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) {
+        return PutIfAbsent(key, value);
+    }
+
+    virtual bool Set(const std::string &key, uint64_t hash, const std::string &value) { return Set(key, value); }
+
+    virtual bool Get(const std::string &key, uint64_t hash, std::string &value) { return Get(key, value); }
+
+    virtual bool GetChunks(const std::string &key, uint64_t hash,
+                           std::vector<std::shared_ptr<const std::string>> &chunks) {
+        return GetChunks(key, chunks);
+    }
+
+    virtual bool Append(const std::string &key, uint64_t hash, const std::string &data) { return Append(key, data); }
+
+    /**
+     * Retrive keys starting with the given prefix in ascending order
+     * Method appends to the output parameter not more than count keys which are greater than
+     * the given one, so that caller could continue scan from the last key it has seen. Scan
+     * doesn't affect keys "freshness".
+     *
+     * Method returns false if storage can't iterate keys in order, in that case output parameter
+     * stays untouched
+     *
+     * @param prefix all returned keys must start with
+     * @param after key to continue scan after, empty one to start from the beginning
+     * @param count maximum number of keys to return
+     * @param keys output parameter to append keys to
+     */
+    virtual bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+                      std::vector<std::string> &keys) {
+        return false;
+    }
+
+    /**
+     * Removes associations for keys starting with the given prefix
+     * Method removes not more than count keys at once, so that caller could split large
+     * removal into bounded chunks and let other clients to access storage in between. Once
+     * the number of deleted keys is less than count there are no more keys with the prefix.
+     *
+     * Method returns false if storage can't iterate keys in order, in that case storage stays
+     * unchanged
+     *
+     * @param prefix of keys to be removed
+     * @param count maximum number of keys to remove
+     * @param deleted output parameter, number of keys actually removed
+     */
+    virtual bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) { return false; }
+
+    /**
+     * Changes limit of the memory storage keeps associations in. Once limit goes below the current
+     * usage storage evicts the least recently used associations, in background if storage has
+     * background maintenance
+     *
+     * Method returns false if storage can't be resized at runtime
+     *
+     * @param max_size new limit in bytes
+     */
+    virtual bool Resize(std::size_t max_size) { return false; }
+
+    /**
+     * Collects implementation specific counters of the storage. Each counter is
+     * a name/value pair appended to the given output, those are reported to clients
+     * by the "stats" command
+     *
+     * @param stats output parameter to append counters to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) {}
+
+    /**
+     * Collects state of the memory allocator the storage keeps its data in, see Allocator::Simple::dump.
+     * Those are reported by the "stats allocator" command, storages using the global heap only have
+     * nothing to add
+     *
+     * @param stats output parameter to append counters to
+     */
+    virtual void AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) {}
+
+    /**
+     * Creates child process as fork(2) does, making sure that no storage operation is in progress
+     * at that moment in any thread. Child gets consistent copy-on-write image of the storage which
+     * could be read by Dump, while parent continues to serve clients.
+     *
+     * Method returns child pid in the parent, 0 in the child and -1 if storage doesn't support that
+     * or fork failed, errno is set in that case
+     */
+    virtual pid_t Fork() {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    /**
+     * Visits all associations of the storage. Storage may consist of several independent parts, then
+     * each part is visited entirely before the next one. Inside of a part associations are visited
+     * starting from the least recently used, so that putting them in the same order restores storage
+     * state. Dump doesn't affect keys "freshness".
+     *
+     * Method returns false if storage can't enumerate associations
+     *
+     * @param visit called with index of the part, key and value of every association
+     */
+    virtual bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+        return false;
+    }
+
+    /**
+     * Starts writing storage image to the snapshot file in background, see Backend::SnapshotStorage
+     *
+     * Method returns false if snapshots aren't configured or another one is in progress
+     */
+    virtual bool Snapshot() { return false; }
 };
 
 } // namespace Afina
@@ -0,0 +1,89 @@
+#ifndef AFINA_ALLOCATOR_ARENA_H
+#define AFINA_ALLOCATOR_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <afina/allocator/TaggedStack.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Arena
+ * The lowest level of the Arena -> SlabCache -> Mempool stack: maps memory from the system in large
+ * regions and hands it out as slabs of the fixed size aligned to that size. Freed slabs are kept for
+ * reuse, memory goes back to the system only once arena gets destroyed.
+ *
+ * Alloc and Free are lock-free, the lock is taken only to map the next region.
+ *
+ * With huge pages enabled regions get mapped by MapHugePages, so that slabs take fewer TLB entries.
+ * Slabs smaller than the huge page can't come from hugetlb, their regions are only advised to the
+ * transparent huge pages
+ */
+class Arena {
+public:
+    /**
+     * @param slab_size size of the slabs, power of two
+     * @param region_size bytes mapped at once, multiple of slab_size
+     * @param huge_pages back regions by huge pages
+     */
+    Arena(std::size_t slab_size = 4 << 20, std::size_t region_size = 64 << 20, bool huge_pages = false);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Returns slab, nullptr if system refuses to give more memory
+     */
+    void *Alloc();
+
+    /**
+     * Returns slab to the arena
+     */
+    void Free(void *slab);
+
+    std::size_t SlabSize() const { return _slab_size; }
+
+    /**
+     * Enables or disables huge pages for regions mapped from now on
+     */
+    void HugePages(bool enabled) { _huge_pages.store(enabled, std::memory_order_relaxed); }
+
+    bool HugePages() const { return _huge_pages.load(std::memory_order_relaxed); }
+
+    /**
+     * Bytes of the mapped regions the kernel backs by huge pages at the moment, see HugePageBytes
+     */
+    std::size_t HugeBytes();
+
+    /**
+     * Bytes mapped by the arena
+     */
+    std::size_t Mapped() const { return _mapped.load(std::memory_order_relaxed); }
+
+private:
+    // Maps the next region and puts its slabs to the free stack, returns false on failure
+    bool Grow();
+
+    const std::size_t _slab_size;
+    const std::size_t _region_size;
+
+    TaggedStack _free;
+
+    std::atomic<std::size_t> _mapped;
+
+    std::atomic<bool> _huge_pages;
+
+    // Guards _regions, serializes mapping of the regions
+    std::mutex _lock;
+    std::vector<void *> _regions;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_ARENA_H
@@ -0,0 +1,39 @@
+#ifndef AFINA_ALLOCATOR_HUGE_PAGES_H
+#define AFINA_ALLOCATOR_HUGE_PAGES_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * Size of the huge pages the kernel uses by default
+ */
+const std::size_t kHugePageSize = 2 << 20;
+
+/**
+ * Maps anonymous private memory backed by huge pages: MAP_HUGETLB if the kernel has reserved pages for
+ * it, otherwise regular pages with madvise(MADV_HUGEPAGE), so that transparent huge pages back them once
+ * possible. Returns nullptr on failure
+ * @param size multiple of kHugePageSize
+ * @param hugetlb set to true if memory comes from MAP_HUGETLB
+ */
+void *MapHugePages(std::size_t size, bool &hugetlb);
+
+/**
+ * Bytes of the given ranges backed by huge pages as /proc/self/smaps reports, both transparent and
+ * hugetlb. Mapping which a range shares with other memory is taken in proportion to the overlap.
+ * Reading smaps is slow, so ranges are checked all at once
+ */
+std::size_t HugePageBytes(const std::vector<std::pair<const void *, std::size_t>> &ranges);
+
+inline std::size_t HugePageBytes(const void *address, std::size_t size) {
+    return HugePageBytes({std::make_pair(address, size)});
+}
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_HUGE_PAGES_H
@@ -0,0 +1,80 @@
+#ifndef AFINA_ALLOCATOR_MEMPOOL_H
+#define AFINA_ALLOCATOR_MEMPOOL_H
+
+#include <atomic>
+#include <cstddef>
+
+#include <afina/allocator/SlabCache.h>
+#include <afina/allocator/TaggedStack.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Pool of the fixed size objects
+ * The top level of the Arena -> SlabCache -> Mempool stack: cuts slabs into objects of the same size and
+ * keeps free objects in the lock-free stack. Once stack is empty the next slab gets cut and its objects go
+ * to the stack at once. Slabs stay with the pool until it is destroyed, so memory of the pool is the peak
+ * number of its objects.
+ *
+ * Alloc and Free are lock-free and could be called from any thread
+ */
+class Mempool {
+public:
+    static const std::size_t kAlignment = 16;
+
+    /**
+     * @param cache slabs come from
+     * @param object_size size of the objects, rounded up to kAlignment
+     */
+    Mempool(SlabCache &cache, std::size_t object_size);
+    ~Mempool();
+
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    /**
+     * Returns object aligned to kAlignment, nullptr if there is no memory
+     */
+    void *Alloc();
+
+    /**
+     * Returns object allocated by this pool
+     */
+    void Free(void *object);
+
+    /**
+     * Returns chain of objects linked through their first words, see TaggedStack::Link, at once
+     */
+    void Free(void *first, void *last);
+
+    std::size_t ObjectSize() const { return _object_size; }
+
+    /**
+     * Bytes of slabs taken by the pool
+     */
+    std::size_t Size() const { return _slabs.load(std::memory_order_relaxed) * _slab_size; }
+
+private:
+    // Objects the slab is chosen to fit at least
+    static const std::size_t kObjectsPerSlab = 64;
+
+    // Takes the next slab, returns one of its objects and puts the rest to the free stack
+    void *Refill();
+
+    SlabCache &_cache;
+
+    std::size_t _object_size;
+    std::size_t _slab_size;
+
+    TaggedStack _free;
+
+    // Slabs taken, linked through the header in front of their objects, returned to the cache by destructor
+    std::atomic<std::size_t> _slabs;
+    TaggedStack _taken;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_MEMPOOL_H
@@ -1,12 +1,24 @@
 #ifndef AFINA_ALLOCATOR_POINTER_H
 #define AFINA_ALLOCATOR_POINTER_H
 
+#include <cstddef>
+#include <cstdint>
+
 namespace Afina {
 namespace Allocator {
 // Forward declaration. Do not include real class definition
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Reference to the memory allocated by Simple. Pointer keeps offset of the handle from the beginning
+ * of the area rather than the address, so that the offset could be stored inside of the area itself and
+ * stays valid once area gets mapped at the other address, see Simple::get. Handle is the slot holding
+ * offset of the allocation: Simple::defrag and Simple::realloc move data and update the slot, so
+ * pointer stays the same while the address it gives may change.
+ *
+ * Offset takes 64 bits, references kept in large numbers could be packed to 32, see Simple::compact
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +29,23 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const {
+        char *base = static_cast<char *>(_base);
+        return _offset == 0 ? nullptr : base + *reinterpret_cast<const uint64_t *>(base + _offset);
+    }
+
+    /**
+     * Position independent form of the pointer, zero for the empty one
+     */
+    std::size_t offset() const { return _offset; }
+
+private:
+    friend class Simple;
+
+    Pointer(void *base, std::size_t offset);
+
+    void *_base;
+    std::size_t _offset;
 };
 
 } // namespace Allocator
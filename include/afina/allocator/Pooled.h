@@ -0,0 +1,75 @@
+#ifndef AFINA_ALLOCATOR_POOLED_H
+#define AFINA_ALLOCATOR_POOLED_H
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Objects allocated from mempools
+ * Classes deriving from Pooled get their instances from the process-wide set of Mempools, one per
+ * size class of kStep bytes up to kMaxSize, over the single SlabCache and Arena. Larger objects
+ * fall back to the global heap. Types which can't derive, such as aggregates, could call Alloc
+ * and Free from their own operator new and delete.
+ *
+ * Each thread keeps magazine of free objects per size class in front of the pools, so that the
+ * common allocation and free touch nothing shared. Magazine gets refilled from the pool and
+ * drained back to it by batches, once it grows above the high-water mark of two batches half of
+ * it goes back. Thread returns all its magazines on exit, so memory never stays with threads
+ * which are gone.
+ *
+ * Object of the derived class must be deleted through the pointer to its own type or the base with
+ * virtual destructor, so that operator delete gets the right size
+ */
+class Pooled {
+public:
+    static const std::size_t kStep = 16;
+    static const std::size_t kMaxSize = 1024;
+
+    /**
+     * Returns memory for the object of the given size, throws std::bad_alloc if there is none
+     */
+    static void *Alloc(std::size_t size);
+
+    /**
+     * Releases memory taken by Alloc with the same size
+     */
+    static void Free(void *p, std::size_t size);
+
+    static void *operator new(std::size_t size) { return Alloc(size); }
+
+    static void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+        try {
+            return Alloc(size);
+        } catch (std::bad_alloc &) {
+            return nullptr;
+        }
+    }
+
+    static void operator delete(void *p, std::size_t size) { Free(p, size); }
+
+    /**
+     * Bytes of slabs taken by all pools
+     */
+    static std::size_t Size();
+
+    /**
+     * Enables huge pages for memory pools take from now on, see Arena
+     */
+    static void HugePages(bool enabled);
+
+    /**
+     * Appends pool_* counters of memory usage and huge page coverage for the stats command
+     */
+    static void Stats(std::vector<std::pair<std::string, std::string>> &stats);
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_POOLED_H
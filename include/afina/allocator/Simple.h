@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cstddef>
+#include <cstdint>
 
 namespace Afina {
 namespace Allocator {
@@ -18,44 +19,162 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * All allocator state lives inside of the area and refers to blocks by offsets, so that
+ * area could be shared memory reattached by the other process at the other address,
+ * see attached(). Allocator isn't thread safe
+ *
+ * Pointers are handles: slots of the table at the end of the area holding offsets of the
+ * allocations, so blocks could be moved. Free blocks live in segregated lists by size
+ * class with bitmaps of non-empty lists, alloc and free run in constant time, neighbour
+ * free blocks get merged using sizes kept at both ends of the block
+ *
+ * See StlAllocator for the adapter to the standard allocator interface
  */
-// TODO: Implements interface to allow usage as C++ allocators
 class Simple {
 public:
-    Simple(void *base, const size_t size);
+    /**
+     * @param base beginning of the area, must be aligned to 8 bytes
+     * @param size size of the area
+     * @param attach reuse allocator state the area already holds, if any
+     */
+    Simple(void *base, const size_t size, bool attach = false);
 
     /**
-     * TODO: semantics
+     * Allocates N bytes aligned to 8 bytes, throws AllocError(NoMemory) if there is
+     * no free block large enough
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the allocation keeping its content, empty pointer gets allocated.
+     * Shrink and growth into the free neighbour happen in place, otherwise data moves, the
+     * pointer stays the same but gives the new address
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases allocation and resets pointer, empty pointer is ignored. Throws
+     * AllocError(InvalidFree) if pointer doesn't refer to the allocated block
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Compacts allocations to the beginning of the area, so that all free memory becomes
+     * the single block. Pointers stay valid but addresses they give change, so addresses
+     * taken before must not be used after. Takes time linear in the size of allocations
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Step of the incremental compaction: moves allocations towards the beginning of the area
+     * one by one, continuing from where the previous step stopped, until step moves more than
+     * max_bytes or runs longer than max_time microseconds. Zero means no limit, at least one
+     * allocation gets moved anyway. Pointers stay valid but addresses they give change, so
+     * addresses taken before the step must not be used after it.
+     *
+     * Returns number of bytes moved, zero once area is compact
+     */
+    size_t defrag(size_t max_bytes, size_t max_time);
+
+    /**
+     * Part of free memory outside of the largest free block, from 0 when free memory is the
+     * single block to almost 1 when it is scattered over many small ones
+     */
+    double fragmentation() const;
+
+    /**
+     * Report on the area state, one "<name> <value>" line per counter:
+     * - size, used, available, largest_free, fragmentation: memory in bytes. Failed allocation with
+     *   available memory much larger than largest_free means area is fragmented rather than full
+     * - used_blocks, free_blocks: number of blocks
+     * - free_blocks_<n>, free_bytes_<n>: histogram of free blocks of size from n up to 2n
+     * - region_<i>_utilization: part of the i-th of 16 equal parts of the area taken by allocations
+     * - handles, handles_used, handles_free: size and occupancy of the handle table
+     * - buddy: 1 in the buddy mode
+     * - alloc_failures: allocations failed for lack of memory since the area got formatted
+     * - defrag_runs, defrag_steps, defrag_bytes, defrag_time_us: full and incremental compactions,
+     *   bytes they moved and time they took
      */
     std::string dump() const;
 
+    /**
+     * Restores pointer from its offset, see Pointer::offset
+     */
+    Pointer get(size_t offset) const;
+
+    /**
+     * Restores pointer from the address it gives, throws AllocError(InvalidFree) if address
+     * isn't the beginning of the allocation
+     */
+    Pointer at(const void *address) const;
+
+    /**
+     * Packs offset of the pointer into 32 bits: number of its handle counting from the top of the
+     * handle table. Handles are 8 bytes apart, so compact form refers to any of up to 2^32 - 1
+     * allocations whatever the area size is, zero stays the empty pointer. Meant for references
+     * kept in large numbers inside of the area, such as list links and index slots
+     */
+    uint32_t compact(size_t offset) const { return offset == 0 ? 0 : uint32_t((top() - offset) / 8 + 1); }
+
+    /**
+     * Offset of the pointer from its compact form, see compact
+     */
+    size_t expand(uint32_t handle) const { return handle == 0 ? 0 : top() - size_t(handle - 1) * 8; }
+
+    /**
+     * Offset of the allocation marked as root, zero if there is no root. Root is where owner
+     * of the area finds its data once area gets attached again
+     */
+    size_t root() const;
+
+    /**
+     * Marks allocation as root
+     */
+    void root(const Pointer &p);
+
+    /**
+     * True in the buddy mode: block sizes get rounded up to powers of two, as in the binary buddy
+     * allocator, so that realloc growing the allocation by small steps mostly stays within its block
+     * and, once it doesn't fit, doubles merging the free neighbour in place before it has to move.
+     * Suits values growing by appends at the cost of up to half of the block wasted
+     */
+    bool buddy() const;
+
+    /**
+     * Switches the buddy mode, mode is kept in the area. Blocks allocated before keep their sizes,
+     * rounding applies to allocations and reallocations from now on
+     */
+    void buddy(bool enabled);
+
+    /**
+     * True if constructor found and reused allocator state in the area, false if the area has
+     * been formatted from scratch
+     */
+    bool attached() const { return _attached; }
+
+    /**
+     * Bytes taken by allocated blocks including their headers
+     */
+    size_t used() const;
+
+    /**
+     * Bytes of free blocks. Allocation of this size could fail until defrag() if free memory
+     * is scattered over many blocks
+     */
+    size_t available() const;
+
 private:
+    // Offset of the first handle, table grows down from it
+    size_t top() const { return (_base_len & ~size_t(7)) - 8; }
+
     void *_base;
     const size_t _base_len;
+    bool _attached;
 };
 
 } // namespace Allocator
@@ -0,0 +1,63 @@
+#ifndef AFINA_ALLOCATOR_SLAB_CACHE_H
+#define AFINA_ALLOCATOR_SLAB_CACHE_H
+
+#include <cstddef>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/TaggedStack.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Slab cache
+ * The middle level of the Arena -> SlabCache -> Mempool stack: hands out slabs of power of two sizes from
+ * kMinSize up to the slab size of the arena, each aligned to its size. Larger slab is split in halves once
+ * there is no free slab of the requested size, halves are kept in free stacks by size and never merge back.
+ *
+ * Alloc and Free are lock-free
+ */
+class SlabCache {
+public:
+    static const std::size_t kMinSize = 4096;
+
+    SlabCache(Arena &arena);
+
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    /**
+     * Returns slab of Size(size) bytes, nullptr if there is no memory
+     */
+    void *Alloc(std::size_t size);
+
+    /**
+     * Returns slab of the given size back to the cache
+     */
+    void Free(void *slab, std::size_t size);
+
+    /**
+     * Size of the slab given for the request of the given size, zero if it is larger than the arena slab
+     */
+    std::size_t Size(std::size_t size) const;
+
+private:
+    static const std::size_t kMaxOrders = 32;
+
+    // Index of the free stack for the slabs of the given size
+    std::size_t Order(std::size_t size) const;
+
+    void *Alloc(std::size_t order, std::size_t size);
+
+    Arena &_arena;
+
+    // Order of the arena slabs
+    std::size_t _orders;
+
+    TaggedStack _free[kMaxOrders];
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_CACHE_H
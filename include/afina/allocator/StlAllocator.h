@@ -0,0 +1,66 @@
+#ifndef AFINA_ALLOCATOR_STL_ALLOCATOR_H
+#define AFINA_ALLOCATOR_STL_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * Adapts Simple to the standard allocator requirements, so that strings and containers could keep their
+ * memory in the area of Simple instead of the global heap. Copies and rebinds share the same Simple, memory
+ * of the container goes away with the area at once.
+ *
+ * Containers keep raw addresses, so area they allocate from must not be compacted by Simple::defrag and
+ * their allocations must not be reallocated through Simple directly. Failed allocation throws
+ * std::bad_alloc as containers expect
+ */
+template <typename T> class StlAllocator {
+public:
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit StlAllocator(Simple &simple) : _simple(&simple) {}
+
+    template <typename U> StlAllocator(const StlAllocator<U> &other) : _simple(other.simple()) {}
+
+    T *allocate(std::size_t n) {
+        try {
+            return static_cast<T *>(_simple->alloc(n * sizeof(T)).get());
+        } catch (AllocError &) {
+            throw std::bad_alloc();
+        }
+    }
+
+    void deallocate(T *p, std::size_t) {
+        Pointer pointer = _simple->at(p);
+        _simple->free(pointer);
+    }
+
+    Simple *simple() const { return _simple; }
+
+private:
+    Simple *_simple;
+};
+
+template <typename T, typename U> bool operator==(const StlAllocator<T> &a, const StlAllocator<U> &b) {
+    return a.simple() == b.simple();
+}
+
+template <typename T, typename U> bool operator!=(const StlAllocator<T> &a, const StlAllocator<U> &b) {
+    return a.simple() != b.simple();
+}
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_STL_ALLOCATOR_H
@@ -0,0 +1,71 @@
+#ifndef AFINA_ALLOCATOR_TAGGED_STACK_H
+#define AFINA_ALLOCATOR_TAGGED_STACK_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Lock-free stack of free memory blocks
+ * Treiber stack: the first word of the free block refers to the next one. Head keeps the counter in 16
+ * bits above the 48-bit address, every change increments it, so that block popped and pushed back by
+ * other threads between load and CAS doesn't corrupt the stack (ABA problem).
+ *
+ * Pop reads link of the block which could be popped and overwritten concurrently, CAS fails in this
+ * case. That's safe as long as memory of blocks never gets unmapped while stack is in use
+ */
+class TaggedStack {
+public:
+    TaggedStack() : _head(0) {}
+
+    void Push(void *block) { Push(block, block); }
+
+    /**
+     * Pushes chain of blocks already linked from first to last at once
+     */
+    void Push(void *first, void *last) {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        do {
+            Link(last) = Address(head);
+        } while (!_head.compare_exchange_weak(head, Tagged(first, head), std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    /**
+     * Returns block from the top of the stack, nullptr if stack is empty
+     */
+    void *Pop() {
+        uint64_t head = _head.load(std::memory_order_acquire);
+        while (Address(head) != nullptr) {
+            void *next = Link(Address(head));
+            if (_head.compare_exchange_weak(head, Tagged(next, head), std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return Address(head);
+            }
+        }
+        return nullptr;
+    }
+
+    bool Empty() const { return Address(_head.load(std::memory_order_acquire)) == nullptr; }
+
+    static void *&Link(void *block) { return *static_cast<void **>(block); }
+
+private:
+    static const uint64_t kAddressMask = (uint64_t(1) << 48) - 1;
+
+    static void *Address(uint64_t head) { return reinterpret_cast<void *>(head & kAddressMask); }
+
+    // New head referring to the given block with the counter of the previous head incremented
+    static uint64_t Tagged(void *block, uint64_t head) {
+        return reinterpret_cast<uint64_t>(block) | ((head & ~kAddressMask) + (kAddressMask + 1));
+    }
+
+    std::atomic<uint64_t> _head;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_TAGGED_STACK_H
@@ -8,6 +8,7 @@
 #include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace Afina {
 namespace Concurrency {
@@ -28,6 +29,7 @@ class Executor {
         kStopped
     };
 
+public:
     Executor(std::string name, int size);
     ~Executor();
 
@@ -97,6 +99,21 @@ private:
      * Flag to stop bg threads
      */
     State state;
+
+    /**
+     * Name of the pool, used to identify threads
+     */
+    std::string name;
+
+    /**
+     * Number of threads still running perform loop
+     */
+    std::size_t alive;
+
+    /**
+     * Conditional variable to await for all threads to stop
+     */
+    std::condition_variable stop_condition;
 };
 
 } // namespace Concurrency
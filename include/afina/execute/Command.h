@@ -1,7 +1,11 @@
 #ifndef AFINA_EXECUTE_COMMAND_H
 #define AFINA_EXECUTE_COMMAND_H
 
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <afina/allocator/Pooled.h>
 
 namespace Afina {
 
@@ -13,12 +17,23 @@ namespace Execute {
  *
  *
  */
-class Command {
+class Command : public Allocator::Pooled {
 public:
     Command() {}
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Same as Execute, but response is the sequence of pieces to be sent one after another. Pieces
+     * may share memory with the storage, so that large values go to the socket without copies
+     */
+    virtual void ExecuteChunks(Storage &storage, const std::string &args,
+                               std::vector<std::shared_ptr<const std::string>> &out) {
+        std::string result;
+        Execute(storage, args, result);
+        out.emplace_back(new std::string(std::move(result)));
+    }
 };
 
 } // namespace Execute
@@ -0,0 +1,36 @@
+#ifndef AFINA_EXECUTE_DELETE_PREFIX_H
+#define AFINA_EXECUTE_DELETE_PREFIX_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Remove all keys in the namespace
+ * Delete all keys starting with the given prefix. Keys are removed from the storage by bounded
+ * chunks, so that other clients are able to access storage while large namespace gets invalidated
+ *
+ * Command must write result to the output, which could be:
+ * - "DELETED <count>" to indicate success, where count is the number of keys removed
+ * - "SERVER_ERROR <message>" if storage can't iterate keys by prefix
+ */
+class DeletePrefix : public Command {
+public:
+    DeletePrefix(const std::string &prefix) : _prefix(prefix) {}
+    ~DeletePrefix() {}
+
+    inline const std::string &prefix() const { return _prefix; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _prefix;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_DELETE_PREFIX_H
@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_GET_H
 #define AFINA_EXECUTE_GET_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -34,15 +35,25 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    /**
+     * @param keys to retrive values for
+     * @param hashes of the keys computed by the parser, see Storage::Get
+     */
+    Get(const std::vector<std::string> &keys, const std::vector<uint64_t> &hashes) : _keys(keys), _hashes(hashes) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline const std::vector<uint64_t> &hashes() const { return _hashes; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Values go out in chunks the storage keeps them in, see Storage::GetChunks
+    void ExecuteChunks(Storage &storage, const std::string &args,
+                       std::vector<std::shared_ptr<const std::string>> &out) override;
+
 private:
     std::vector<std::string> _keys;
+    std::vector<uint64_t> _hashes;
 };
 
 } // namespace Execute
@@ -11,21 +11,24 @@ namespace Execute {
 
 /**
  * # Basic class for all insert commands
- *
+ * Command carries hash of the key computed by the parser, see Storage::Put
  */
 class InsertCommand : public Command {
 public:
-    InsertCommand(const std::string &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
+    InsertCommand(const std::string &key, uint32_t flags, int32_t expire, uint64_t hash)
+        : _key(key), _flags(flags), _expire(expire), _hash(hash) {}
     ~InsertCommand() {}
 
     inline const std::string &key() const { return _key; }
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
+    inline const uint64_t hash() const { return _hash; }
 
 protected:
     const std::string _key;
     const uint32_t _flags;
     const int32_t _expire;
+    const uint64_t _hash;
 };
 
 } // namespace Execute
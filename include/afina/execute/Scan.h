@@ -0,0 +1,47 @@
+#ifndef AFINA_EXECUTE_SCAN_H
+#define AFINA_EXECUTE_SCAN_H
+
+#include <cstddef>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Iterate keys in the namespace
+ * Returns portion of keys starting with the given prefix in ascending order. Cursor tells where
+ * iteration must continue from, "0" starts a new one. Each response contains cursor for the next
+ * call, once it is "0" there are no more keys.
+ *
+ * Response looks like this:
+ * KEY <key>\r\n
+ * KEY ....
+ * CURSOR <cursor>\r\n
+ * END
+ *
+ * Or "SERVER_ERROR <message>" if storage can't iterate keys by prefix
+ */
+class Scan : public Command {
+public:
+    Scan(const std::string &prefix, const std::string &cursor, std::size_t count)
+        : _prefix(prefix), _cursor(cursor), _count(count) {}
+    ~Scan() {}
+
+    inline const std::string &prefix() const { return _prefix; }
+    inline const std::string &cursor() const { return _cursor; }
+    inline std::size_t count() const { return _count; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _prefix;
+    std::string _cursor;
+    std::size_t _count;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_SCAN_H
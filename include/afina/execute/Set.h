@@ -21,7 +21,8 @@ namespace Execute {
  */
 class Set : public InsertCommand {
 public:
-    Set(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
+    Set(const std::string &key, uint32_t flags, int32_t expire, uint64_t hash)
+        : InsertCommand(key, flags, expire, hash) {}
     ~Set() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
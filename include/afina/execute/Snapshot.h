@@ -0,0 +1,31 @@
+#ifndef AFINA_EXECUTE_SNAPSHOT_H
+#define AFINA_EXECUTE_SNAPSHOT_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Save storage image
+ * Starts writing storage snapshot to the file in background, so that server could be restarted
+ * with warm cache. Progress is reported by the "stats" command
+ *
+ * Command must write result to the output, which could be:
+ * - "OK" to indicate snapshot is started
+ * - "SERVER_ERROR <message>" if snapshots aren't configured or another one is in progress
+ */
+class Snapshot : public Command {
+public:
+    Snapshot() {}
+    ~Snapshot() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_SNAPSHOT_H
@@ -8,11 +8,23 @@
 namespace Afina {
 namespace Execute {
 
+/**
+ * # Server counters
+ * Without arguments reports counters of the storage and the object pools. With "allocator" group
+ * reports state of the allocators instead: fragmentation maps and histograms of the storage allocator,
+ * see Storage::AllocatorStats, and the object pools
+ */
 class Stats : public Command {
 public:
-    Stats() {}
+    Stats(const std::string &group = "") : _group(group) {}
     ~Stats() {}
+
+    inline const std::string &group() const { return _group; }
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _group;
 };
 
 } // namespace Execute
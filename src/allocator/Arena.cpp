@@ -0,0 +1,96 @@
+#include <afina/allocator/Arena.h>
+
+#include <cstdint>
+
+#include <afina/allocator/HugePages.h>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See Arena.h
+Arena::Arena(std::size_t slab_size, std::size_t region_size, bool huge_pages)
+    : _slab_size(slab_size), _region_size(region_size), _mapped(0), _huge_pages(huge_pages) {}
+
+// See Arena.h
+Arena::~Arena() {
+    for (void *region : _regions) {
+        munmap(region, _region_size);
+    }
+}
+
+// See Arena.h
+void *Arena::Alloc() {
+    void *slab;
+    while ((slab = _free.Pop()) == nullptr) {
+        if (!Grow()) {
+            return nullptr;
+        }
+    }
+    return slab;
+}
+
+// See Arena.h
+void Arena::Free(void *slab) { _free.Push(slab); }
+
+// See Arena.h
+std::size_t Arena::HugeBytes() {
+    std::vector<std::pair<const void *, std::size_t>> ranges;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        for (void *region : _regions) {
+            ranges.emplace_back(region, _region_size);
+        }
+    }
+    return ranges.empty() ? 0 : HugePageBytes(ranges);
+}
+
+/**
+ * Region is mapped larger by the slab size and trimmed, so that slabs are aligned to their size. Thread
+ * which waited for the lock finds slabs mapped by the other one and returns at once. Hugetlb mapping is
+ * aligned to the huge page, so trimming by multiples of the slab size keeps it whole pages
+ */
+bool Arena::Grow() {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_free.Empty()) {
+        return true;
+    }
+
+    std::size_t size = _region_size + _slab_size;
+    void *area;
+    bool hugetlb;
+    if (HugePages() && _slab_size % kHugePageSize == 0) {
+        area = MapHugePages(size, hugetlb);
+    } else {
+        area = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        area = area != MAP_FAILED ? area : nullptr;
+        if (area != nullptr && HugePages()) {
+            madvise(area, size, MADV_HUGEPAGE);
+        }
+    }
+    if (area == nullptr) {
+        return false;
+    }
+
+    char *begin = static_cast<char *>(area);
+    char *region = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(begin) + _slab_size - 1) & ~(_slab_size - 1));
+    if (region != begin) {
+        munmap(begin, region - begin);
+    }
+    if (region + _region_size != begin + size) {
+        munmap(region + _region_size, begin + size - region - _region_size);
+    }
+    _regions.push_back(region);
+
+    char *last = region + _region_size - _slab_size;
+    for (char *slab = region; slab < last; slab += _slab_size) {
+        TaggedStack::Link(slab) = slab + _slab_size;
+    }
+    _free.Push(region, last);
+    _mapped.fetch_add(_region_size, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,73 @@
+#include <afina/allocator/HugePages.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See HugePages.h
+void *MapHugePages(std::size_t size, bool &hugetlb) {
+    void *area = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (area != MAP_FAILED) {
+        hugetlb = true;
+        return area;
+    }
+
+    hugetlb = false;
+    area = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED) {
+        return nullptr;
+    }
+
+    // Kernel without THP rejects advice, memory still works with regular pages
+    madvise(area, size, MADV_HUGEPAGE);
+    return area;
+}
+
+/**
+ * Walks mappings in /proc/self/smaps summing huge page counters of those overlapping the ranges
+ */
+std::size_t HugePageBytes(const std::vector<std::pair<const void *, std::size_t>> &ranges) {
+    FILE *smaps = std::fopen("/proc/self/smaps", "r");
+    if (smaps == nullptr) {
+        return 0;
+    }
+
+    static const char *const counters[] = {"AnonHugePages: %lu kB", "ShmemPmdMapped: %lu kB",
+                                           "Private_Hugetlb: %lu kB", "Shared_Hugetlb: %lu kB"};
+
+    // Part of the current mapping covered by ranges
+    double share = 0;
+    double result = 0;
+    char line[512];
+    while (std::fgets(line, sizeof(line), smaps) != nullptr) {
+        unsigned long begin, end;
+        if (std::sscanf(line, "%lx-%lx ", &begin, &end) == 2) {
+            std::size_t covered = 0;
+            for (auto &range : ranges) {
+                uintptr_t from = std::max<uintptr_t>(begin, reinterpret_cast<uintptr_t>(range.first));
+                uintptr_t to = std::min<uintptr_t>(end, reinterpret_cast<uintptr_t>(range.first) + range.second);
+                covered += from < to ? to - from : 0;
+            }
+            share = double(covered) / (end - begin);
+            continue;
+        }
+
+        unsigned long kb;
+        for (const char *counter : counters) {
+            if (share > 0 && std::sscanf(line, counter, &kb) == 1) {
+                result += share * (kb << 10);
+                break;
+            }
+        }
+    }
+    std::fclose(smaps);
+    return std::size_t(result);
+}
+
+} // namespace Allocator
+} // namespace Afina
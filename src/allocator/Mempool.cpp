@@ -0,0 +1,64 @@
+#include <afina/allocator/Mempool.h>
+
+namespace Afina {
+namespace Allocator {
+
+const std::size_t Mempool::kAlignment;
+const std::size_t Mempool::kObjectsPerSlab;
+
+// See Mempool.h
+Mempool::Mempool(SlabCache &cache, std::size_t object_size)
+    : _cache(cache), _object_size((object_size + kAlignment - 1) & ~(kAlignment - 1)),
+      _slab_size(cache.Size(kAlignment + kObjectsPerSlab * _object_size)), _slabs(0) {}
+
+// See Mempool.h
+Mempool::~Mempool() {
+    void *slab;
+    while ((slab = _taken.Pop()) != nullptr) {
+        _cache.Free(slab, _slab_size);
+    }
+}
+
+// See Mempool.h
+void *Mempool::Alloc() {
+    void *object = _free.Pop();
+    return object != nullptr ? object : Refill();
+}
+
+// See Mempool.h
+void Mempool::Free(void *object) { _free.Push(object); }
+
+// See Mempool.h
+void Mempool::Free(void *first, void *last) { _free.Push(first, last); }
+
+/**
+ * Objects of the new slab are linked before the chain gets published by the single push, so that other
+ * threads never see partially built slab
+ */
+void *Mempool::Refill() {
+    if (_slab_size == 0) {
+        return nullptr;
+    }
+
+    char *slab = static_cast<char *>(_cache.Alloc(_slab_size));
+    if (slab == nullptr) {
+        return nullptr;
+    }
+    _taken.Push(slab);
+    _slabs.fetch_add(1, std::memory_order_relaxed);
+
+    char *first = slab + kAlignment;
+    char *last = first + (_slab_size - kAlignment) / _object_size * _object_size - _object_size;
+    if (first == last) {
+        return first;
+    }
+
+    for (char *object = first + _object_size; object < last; object += _object_size) {
+        TaggedStack::Link(object) = object + _object_size;
+    }
+    _free.Push(first + _object_size, last);
+    return first;
+}
+
+} // namespace Allocator
+} // namespace Afina
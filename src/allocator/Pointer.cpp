@@ -3,12 +3,29 @@
 namespace Afina {
 namespace Allocator {
 
-Pointer::Pointer() {}
-Pointer::Pointer(const Pointer &) {}
-Pointer::Pointer(Pointer &&) {}
+Pointer::Pointer() : _base(nullptr), _offset(0) {}
+Pointer::Pointer(void *base, std::size_t offset) : _base(base), _offset(offset) {}
+Pointer::Pointer(const Pointer &other) : _base(other._base), _offset(other._offset) {}
+Pointer::Pointer(Pointer &&other) : _base(other._base), _offset(other._offset) {
+    other._base = nullptr;
+    other._offset = 0;
+}
 
-Pointer &Pointer::operator=(const Pointer &) { return *this; }
-Pointer &Pointer::operator=(Pointer &&) { return *this; }
+Pointer &Pointer::operator=(const Pointer &other) {
+    _base = other._base;
+    _offset = other._offset;
+    return *this;
+}
+
+Pointer &Pointer::operator=(Pointer &&other) {
+    if (this != &other) {
+        _base = other._base;
+        _offset = other._offset;
+        other._base = nullptr;
+        other._offset = 0;
+    }
+    return *this;
+}
 
 } // namespace Allocator
 } // namespace Afina
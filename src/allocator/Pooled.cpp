@@ -0,0 +1,197 @@
+#include <afina/allocator/Pooled.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabCache.h>
+#include <afina/allocator/TaggedStack.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+const std::size_t kPools = Pooled::kMaxSize / Pooled::kStep;
+
+// Objects moved between thread magazine and the pool at once: about kBatchBytes, but no less than
+// kMinBatch and no more than kMaxBatch objects
+const std::size_t kBatchBytes = 4096;
+const std::size_t kMinBatch = 4;
+const std::size_t kMaxBatch = 64;
+
+// Pools get created on the first use. Neither pools nor the cache are ever destroyed, so objects
+// could be freed from destructors of static objects as well
+std::atomic<Mempool *> pools[kPools];
+
+Arena &Slabs() {
+    static Arena *arena = new Arena();
+    return *arena;
+}
+
+SlabCache &Cache() {
+    static SlabCache *cache = new SlabCache(Slabs());
+    return *cache;
+}
+
+inline std::size_t Index(std::size_t size) { return (size - 1) / Pooled::kStep; }
+
+Mempool &Pool(std::size_t index) {
+    std::atomic<Mempool *> &slot = pools[index];
+    Mempool *pool = slot.load(std::memory_order_acquire);
+    if (pool != nullptr) {
+        return *pool;
+    }
+
+    // Threads racing for the same size class build the pool each, all but one throw theirs away
+    Mempool *created = new Mempool(Cache(), (index + 1) * Pooled::kStep);
+    if (slot.compare_exchange_strong(pool, created, std::memory_order_acq_rel)) {
+        return *created;
+    }
+    delete created;
+    return *pool;
+}
+
+inline std::size_t Batch(std::size_t index) {
+    return std::min(kMaxBatch, std::max(kMinBatch, kBatchBytes / ((index + 1) * Pooled::kStep)));
+}
+
+// Free objects of the size class cached by the thread, linked through their first words
+struct Magazine {
+    void *head;
+    std::size_t count;
+};
+
+class ThreadCache {
+public:
+    ThreadCache() : _magazines() {}
+    ~ThreadCache();
+
+    void *Alloc(std::size_t index) {
+        Magazine &magazine = _magazines[index];
+        if (magazine.head == nullptr && !Fill(index)) {
+            return nullptr;
+        }
+
+        void *object = magazine.head;
+        magazine.head = TaggedStack::Link(object);
+        magazine.count--;
+        return object;
+    }
+
+    void Free(std::size_t index, void *object) {
+        Magazine &magazine = _magazines[index];
+        TaggedStack::Link(object) = magazine.head;
+        magazine.head = object;
+        if (++magazine.count > 2 * Batch(index)) {
+            Drain(index, Batch(index));
+        }
+    }
+
+private:
+    // Takes batch of objects from the pool, returns false if pool has none
+    bool Fill(std::size_t index) {
+        Magazine &magazine = _magazines[index];
+        Mempool &pool = Pool(index);
+        for (std::size_t i = Batch(index); i > 0; i--) {
+            void *object = pool.Alloc();
+            if (object == nullptr) {
+                break;
+            }
+            TaggedStack::Link(object) = magazine.head;
+            magazine.head = object;
+            magazine.count++;
+        }
+        return magazine.head != nullptr;
+    }
+
+    // Returns the given number of objects from the head of the magazine to the pool by single push
+    void Drain(std::size_t index, std::size_t count) {
+        Magazine &magazine = _magazines[index];
+        void *first = magazine.head, *last = first;
+        for (std::size_t i = 1; i < count; i++) {
+            last = TaggedStack::Link(last);
+        }
+
+        magazine.head = TaggedStack::Link(last);
+        magazine.count -= count;
+        Pool(index).Free(first, last);
+    }
+
+    Magazine _magazines[kPools];
+};
+
+// Set once the cache of the thread is destroyed, objects freed after that go straight to the pools.
+// Trivial type, so it stays accessible during the thread exit
+thread_local bool cache_destroyed = false;
+
+thread_local ThreadCache cache;
+
+ThreadCache::~ThreadCache() {
+    cache_destroyed = true;
+    for (std::size_t index = 0; index < kPools; index++) {
+        if (_magazines[index].count != 0) {
+            Drain(index, _magazines[index].count);
+        }
+    }
+}
+
+} // namespace
+
+const std::size_t Pooled::kStep;
+const std::size_t Pooled::kMaxSize;
+
+// See Pooled.h
+void *Pooled::Alloc(std::size_t size) {
+    if (size == 0 || size > kMaxSize) {
+        return ::operator new(size);
+    }
+
+    void *p = cache_destroyed ? Pool(Index(size)).Alloc() : cache.Alloc(Index(size));
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// See Pooled.h
+void Pooled::Free(void *p, std::size_t size) {
+    if (p == nullptr) {
+        return;
+    }
+    if (size == 0 || size > kMaxSize) {
+        ::operator delete(p);
+    } else if (cache_destroyed) {
+        Pool(Index(size)).Free(p);
+    } else {
+        cache.Free(Index(size), p);
+    }
+}
+
+// See Pooled.h
+std::size_t Pooled::Size() {
+    std::size_t size = 0;
+    for (std::size_t index = 0; index < kPools; index++) {
+        Mempool *pool = pools[index].load(std::memory_order_acquire);
+        size += pool != nullptr ? pool->Size() : 0;
+    }
+    return size;
+}
+
+// See Pooled.h
+void Pooled::HugePages(bool enabled) { Slabs().HugePages(enabled); }
+
+// See Pooled.h
+void Pooled::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    Arena &arena = Slabs();
+    std::size_t mapped = arena.Mapped(), huge = arena.HugeBytes();
+    stats.emplace_back("pool_bytes", std::to_string(Size()));
+    stats.emplace_back("pool_mapped_bytes", std::to_string(mapped));
+    stats.emplace_back("pool_hugepages", arena.HugePages() ? "1" : "0");
+    stats.emplace_back("pool_hugepage_bytes", std::to_string(huge));
+    stats.emplace_back("pool_hugepage_coverage", std::to_string(mapped != 0 ? double(huge) / mapped : 0.0));
+}
+
+} // namespace Allocator
+} // namespace Afina
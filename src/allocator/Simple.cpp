@@ -1,40 +1,727 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
+namespace {
+
+// Area starts with the header followed by the free list bins, blocks follow them up to the sentinel
+// tag, the rest of the area up to the end is the table of handles growing down. Each block starts with
+// the tag: block size and flags. Used block keeps its handle after the tag, so that block could be
+// moved and handle updated. Free blocks are linked into the bin list of their size and have size
+// copied at the end, so that the following block could find its free neighbour and coalesce.
+//
+// Handle is the slot of the table, it holds offset of the allocation or, if handle is free, the next
+// free handle with kFreeHandle bit set.
+//
+// All references are offsets from the beginning of the area, zero means none
+struct Header {
+    uint64_t magic;
+    uint64_t size;
+    uint64_t used;
+    uint64_t root;
+
+    // Sentinel tag, handle table starts right after it
+    uint64_t end;
+
+    // List of free handles
+    uint64_t handles;
+
+    // Bins are two-level: the highest bit of the block size selects level, the next kSubBits bits
+    // select bin of the level. Bitmaps tell which levels and bins have free blocks, so that search
+    // never walks lists. Level bitmaps and then bin heads follow the header
+    uint64_t levels;
+    uint64_t level_map;
+
+    // Block incremental compaction continues from
+    uint64_t cursor;
+
+    // History reported by Simple::dump: allocations failed for lack of memory, full and incremental
+    // compactions, bytes they moved and microseconds they took
+    uint64_t failures;
+    uint64_t defrag_runs;
+    uint64_t defrag_steps;
+    uint64_t defrag_bytes;
+    uint64_t defrag_time;
+
+    // Non-zero if block sizes are rounded up to powers of two, see Simple::buddy
+    uint64_t buddy;
+};
+
+// "AFALLOC5", changes with the layout of the area
+const uint64_t kMagic = 0x35434f4c4c414641ull;
+
+// Flags in the low bits of the tag
+const uint64_t kUsed = 1;
+const uint64_t kPrevUsed = 2;
+const uint64_t kFlags = 7;
+
+const uint64_t kTagSize = sizeof(uint64_t);
+
+// Tag and handle in front of the allocation
+const uint64_t kHeadSize = 2 * kTagSize;
+
+// Free block must fit tag, list links and the size at the end
+const uint64_t kMinBlock = 4 * kTagSize;
+const uint64_t kMinLevel = 5;
+
+const uint64_t kSubBits = 2;
+const uint64_t kSubs = 1 << kSubBits;
+
+const uint64_t kFreeHandle = 1;
+
+// Handles added once table runs out of them
+const uint64_t kGrowHandles = 32;
+
+// Largest size of the table, handle numbers must fit 32 bits
+const uint64_t kMaxHandles = 0xffffffffull;
+
+// Blocks incremental compaction skips between checks of the clock
+const uint64_t kScanBatch = 256;
+
+// Parts of the area dump reports utilization of
+const uint64_t kDumpRegions = 16;
+
+inline uint64_t HighBit(uint64_t value) { return 63 - __builtin_clzll(value); }
+
+// Bin of the free block with the given size
+inline void Bin(uint64_t size, uint64_t &level, uint64_t &sub) {
+    uint64_t bit = HighBit(size);
+    level = bit - kMinLevel;
+    sub = (size >> (bit - kSubBits)) & (kSubs - 1);
+}
+
+inline uint64_t Levels(uint64_t size) { return HighBit(size) - kMinLevel + 1; }
+
+inline uint64_t First(uint64_t levels) { return sizeof(Header) + levels * (kSubs + 1) * sizeof(uint64_t); }
+
+class Area {
+public:
+    Area(void *base) : _base(static_cast<char *>(base)) {}
+
+    Header &header() { return *reinterpret_cast<Header *>(_base); }
+
+    uint64_t first() { return First(header().levels); }
+
+    uint64_t &word(uint64_t offset) { return *reinterpret_cast<uint64_t *>(_base + offset); }
+
+    uint64_t &tag(uint64_t block) { return word(block); }
+
+    uint64_t size(uint64_t block) { return tag(block) & ~kFlags; }
+
+    bool used(uint64_t block) { return (tag(block) & kUsed) != 0; }
+
+    uint64_t &owner(uint64_t block) { return word(block + kTagSize); }
+
+    uint64_t &next(uint64_t block) { return word(block + kTagSize); }
+
+    uint64_t &prev(uint64_t block) { return word(block + 2 * kTagSize); }
+
+    void footer(uint64_t block) { tag(block + size(block) - kTagSize) = size(block); }
+
+    uint64_t &level_bins(uint64_t level) { return word(sizeof(Header) + level * kTagSize); }
+
+    uint64_t &bin(uint64_t level, uint64_t sub) {
+        return word(sizeof(Header) + (header().levels + level * kSubs + sub) * kTagSize);
+    }
+
+    // Puts free block in the head of the list of its bin
+    void link(uint64_t block) {
+        uint64_t level, sub;
+        Bin(size(block), level, sub);
+
+        uint64_t &head = bin(level, sub);
+        next(block) = head;
+        prev(block) = 0;
+        if (head != 0) {
+            prev(head) = block;
+        }
+        head = block;
+        level_bins(level) |= uint64_t(1) << sub;
+        header().level_map |= uint64_t(1) << level;
+    }
+
+    void unlink(uint64_t block) {
+        uint64_t level, sub;
+        Bin(size(block), level, sub);
+
+        if (prev(block) != 0) {
+            next(prev(block)) = next(block);
+        } else {
+            bin(level, sub) = next(block);
+        }
+        if (next(block) != 0) {
+            prev(next(block)) = prev(block);
+        }
+
+        if (bin(level, sub) == 0) {
+            level_bins(level) &= ~(uint64_t(1) << sub);
+            if (level_bins(level) == 0) {
+                header().level_map &= ~(uint64_t(1) << level);
+            }
+        }
+    }
+
+    // Free block of at least the given size, zero if there is none. Size gets rounded up to the next
+    // bin, so that any block of the bin found fits. Only once there are no larger blocks, the list of
+    // the bin the size itself belongs to gets searched
+    uint64_t find(uint64_t need) {
+        uint64_t level, sub;
+        Bin(need + (uint64_t(1) << (HighBit(need) - kSubBits)) - 1, level, sub);
+        if (level < header().levels) {
+            uint64_t subs = level_bins(level) & (~uint64_t(0) << sub);
+            uint64_t levels = header().level_map & (~uint64_t(0) << (level + 1));
+            if (subs == 0 && levels != 0) {
+                level = __builtin_ctzll(levels);
+                subs = level_bins(level);
+            }
+            if (subs != 0) {
+                return bin(level, __builtin_ctzll(subs));
+            }
+        }
+
+        Bin(need, level, sub);
+        uint64_t block = level < header().levels ? bin(level, sub) : 0;
+        while (block != 0 && size(block) < need) {
+            block = next(block);
+        }
+        return block;
+    }
+
+    // Size of the largest free block, walks the list of the highest non-empty bin only
+    uint64_t largest() {
+        uint64_t level_map = header().level_map;
+        if (level_map == 0) {
+            return 0;
+        }
+
+        uint64_t level = HighBit(level_map);
+        uint64_t largest = 0;
+        for (uint64_t block = bin(level, HighBit(level_bins(level))); block != 0; block = next(block)) {
+            largest = std::max(largest, size(block));
+        }
+        return largest;
+    }
+
+    // Blocks merged into the one starting before the compaction cursor move cursor to its start
+    void merged(uint64_t block, uint64_t size) {
+        uint64_t &cursor = header().cursor;
+        if (cursor > block && cursor < block + size) {
+            cursor = block;
+        }
+    }
+
+    // Turns free block into used one of the given size, the rest stays free if it is large enough
+    void take(uint64_t block, uint64_t need) {
+        uint64_t size = this->size(block);
+        unlink(block);
+        if (size - need >= kMinBlock) {
+            uint64_t rest = block + need;
+            tag(rest) = (size - need) | kPrevUsed;
+            footer(rest);
+            link(rest);
+            size = need;
+        } else {
+            tag(block + size) |= kPrevUsed;
+        }
+
+        tag(block) = size | kUsed | (tag(block) & kPrevUsed);
+        header().used += size;
+    }
+
+    // Turns block into free one merging it with free neighbours
+    void release(uint64_t block) {
+        uint64_t size = this->size(block);
+        uint64_t following = block + size;
+        if (!used(following)) {
+            unlink(following);
+            size += this->size(following);
+        }
+        if ((tag(block) & kPrevUsed) == 0) {
+            uint64_t previous = block - tag(block - kTagSize);
+            unlink(previous);
+            size += block - previous;
+            block = previous;
+        }
+
+        // There are never two free blocks in a row, so the previous one is used now
+        tag(block) = size | kPrevUsed;
+        footer(block);
+        link(block);
+        tag(block + size) &= ~kPrevUsed;
+        merged(block, size);
+    }
+
+    // Moves used block following the free one to the beginning of the free one, free space then
+    // merges with the next free block if any. Returns position of the free block now
+    uint64_t slide(uint64_t hole) {
+        uint64_t space = size(hole);
+        uint64_t block = hole + space;
+        uint64_t size = this->size(block);
+        unlink(hole);
+
+        std::memmove(_base + hole, _base + block, size);
+        word(owner(hole)) = hole + kHeadSize;
+        tag(hole) = size | kUsed | kPrevUsed;
+
+        // Released as if it were used, so that it gets merged and linked
+        tag(hole + size) = space | kUsed | kPrevUsed;
+        release(hole + size);
+        return hole + size;
+    }
+
+    // Cuts the tail of the used block off if it is large enough to be the free block
+    void shrink(uint64_t block, uint64_t need) {
+        uint64_t size = this->size(block);
+        if (size - need < kMinBlock) {
+            return;
+        }
+
+        tag(block) = need | (tag(block) & kFlags);
+        tag(block + need) = (size - need) | kUsed | kPrevUsed;
+        header().used -= size - need;
+        release(block + need);
+    }
+
+    // Takes handle from the free list, zero if table can't grow
+    uint64_t acquire() {
+        Header &h = header();
+        if (h.handles == 0 && !grow()) {
+            return 0;
+        }
+
+        uint64_t handle = h.handles;
+        h.handles = word(handle) & ~kFreeHandle;
+        return handle;
+    }
+
+    void put(uint64_t handle) {
+        Header &h = header();
+        word(handle) = h.handles | kFreeHandle;
+        h.handles = handle;
+    }
+
+    // Moves the sentinel down taking room for more handles from the last block, which must be free
+    bool grow() {
+        Header &h = header();
+        uint64_t end = h.end;
+        if ((tag(end) & kPrevUsed) != 0) {
+            return false;
+        }
+
+        // Handles must stay addressable by 32-bit numbers, see Simple::compact
+        if (((header().size & ~kFlags) - end) / kTagSize + kGrowHandles > kMaxHandles) {
+            return false;
+        }
+
+        uint64_t last = end - tag(end - kTagSize);
+        uint64_t size = this->size(last);
+        uint64_t room = kGrowHandles * kTagSize;
+        unlink(last);
+        if (size < room + kMinBlock) {
+            // Whole block goes to the table, the block before it is used
+            room = size;
+            tag(last) = kUsed | kPrevUsed;
+        } else {
+            tag(last) = (size - room) | kPrevUsed;
+            footer(last);
+            link(last);
+            tag(end - room) = kUsed;
+        }
+
+        h.end = end - room;
+        for (uint64_t handle = end; handle > h.end; handle -= kTagSize) {
+            put(handle);
+        }
+        return true;
+    }
+
+private:
+    char *_base;
+};
+
+} // namespace
+
+// Microseconds since the given moment
+static uint64_t Elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Block size for the allocation of N bytes, power of two in the buddy mode
+static uint64_t Need(Area &area, size_t N, size_t limit) {
+    if (N > limit) {
+        throw AllocError(AllocErrorType::NoMemory, "Allocation is larger than the area");
+    }
+
+    uint64_t need = std::max(kMinBlock, (N + kHeadSize + kFlags) & ~kFlags);
+    if (area.header().buddy != 0 && (need & (need - 1)) != 0) {
+        need = uint64_t(1) << (HighBit(need) + 1);
+    }
+    return need;
+}
+
+// Block of the allocation, throws if pointer doesn't refer to the allocated block
+static uint64_t Block(Area &area, const Pointer &p, size_t limit) {
+    uint64_t handle = p.offset();
+    Header &header = area.header();
+    if (handle <= header.end || handle >= (limit & ~kFlags) || handle % kTagSize != 0 ||
+        (area.word(handle) & kFreeHandle) != 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't refer to the allocated block");
+    }
+
+    uint64_t block = area.word(handle) - kHeadSize;
+    if (block < area.first() || block >= header.end || !area.used(block) || area.owner(block) != handle) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't refer to the allocated block");
+    }
+    return block;
+}
+
+Simple::Simple(void *base, size_t size, bool attach) : _base(base), _base_len(size), _attached(false) {
+    if (size < First(1) + kMinBlock + kTagSize || size < First(Levels(size)) + kMinBlock + kTagSize) {
+        throw AllocError(AllocErrorType::NoMemory, "Area is too small");
+    }
+
+    Area area(base);
+    Header &header = area.header();
+    if (attach && header.magic == kMagic && header.size == size) {
+        _attached = true;
+        return;
+    }
+
+    uint64_t end = (size & ~kFlags) - kTagSize;
+    header.magic = kMagic;
+    header.size = size;
+    header.used = 0;
+    header.root = 0;
+    header.end = end;
+    header.handles = 0;
+    header.levels = Levels(size);
+    header.level_map = 0;
+    header.cursor = area.first();
+    header.failures = 0;
+    header.defrag_runs = 0;
+    header.defrag_steps = 0;
+    header.defrag_bytes = 0;
+    header.defrag_time = 0;
+    header.buddy = 0;
+    std::memset(static_cast<char *>(base) + sizeof(Header), 0, area.first() - sizeof(Header));
+
+    uint64_t first = area.first();
+    area.tag(first) = (end - first) | kPrevUsed;
+    area.footer(first);
+    area.link(first);
+    area.tag(end) = kUsed;
+}
 
 /**
- * TODO: semantics
+ * Takes handle and then the block from the bin found by bitmaps, both in constant time. Allocation
+ * takes the head of the block and the rest goes to the bin of its size
  * @param N size_t
  */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
+Pointer Simple::alloc(size_t N) {
+    Area area(_base);
+    uint64_t need = Need(area, N, _base_len);
+
+    uint64_t handle = area.acquire();
+    if (handle == 0) {
+        area.header().failures++;
+        throw AllocError(AllocErrorType::NoMemory, "No room for the handle");
+    }
+
+    uint64_t block = area.find(need);
+    if (block == 0) {
+        area.put(handle);
+        area.header().failures++;
+        throw AllocError(AllocErrorType::NoMemory, "No free block of size " + std::to_string(need));
+    }
+
+    area.take(block, need);
+    area.owner(block) = handle;
+    area.word(handle) = block + kHeadSize;
+    return Pointer(_base, handle);
+}
 
 /**
- * TODO: semantics
+ * Grows in place if the following block is free and large enough, otherwise moves data to the new
+ * block and points the same handle to it. In the buddy mode block size only changes by powers of two,
+ * so growth within the block costs nothing and moves happen a logarithmic number of times
  * @param p Pointer
  * @param N size_t
  */
-void Simple::realloc(Pointer &p, size_t N) {}
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p.offset() == 0) {
+        p = alloc(N);
+        return;
+    }
+
+    Area area(_base);
+    uint64_t block = Block(area, p, _base_len);
+    uint64_t need = Need(area, N, _base_len);
+    uint64_t size = area.size(block);
+    if (need <= size) {
+        area.shrink(block, need);
+        return;
+    }
+
+    uint64_t following = block + size;
+    if (!area.used(following) && size + area.size(following) >= need) {
+        uint64_t total = size + area.size(following);
+        area.unlink(following);
+        area.tag(block) = total | (area.tag(block) & kFlags);
+        area.tag(block + total) |= kPrevUsed;
+        area.header().used += total - size;
+        area.merged(block, total);
+        area.shrink(block, need);
+        return;
+    }
+
+    uint64_t moved = area.find(need);
+    if (moved == 0) {
+        area.header().failures++;
+        throw AllocError(AllocErrorType::NoMemory, "No free block of size " + std::to_string(need));
+    }
+
+    area.take(moved, need);
+    std::memcpy(static_cast<char *>(_base) + moved + kTagSize, static_cast<char *>(_base) + block + kTagSize,
+                size - kTagSize);
+    area.word(p.offset()) = moved + kHeadSize;
+    area.header().used -= size;
+    area.release(block);
+}
 
 /**
- * TODO: semantics
+ * Coalesces block with free neighbours in constant time using sizes at the end of free blocks
  * @param p Pointer
  */
-void Simple::free(Pointer &p) {}
+void Simple::free(Pointer &p) {
+    if (p.offset() == 0) {
+        return;
+    }
+
+    Area area(_base);
+    uint64_t block = Block(area, p, _base_len);
+    area.header().used -= area.size(block);
+    area.release(block);
+    area.put(p.offset());
+    p = Pointer();
+}
 
 /**
- * TODO: semantics
+ * Slides used blocks down in address order, so that all free space becomes the single block in front
+ * of the handle table. Handles of the moved blocks get updated, so pointers stay valid
  */
-void Simple::defrag() {}
+void Simple::defrag() {
+    Area area(_base);
+    Header &header = area.header();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t first = area.first();
+    std::memset(static_cast<char *>(_base) + sizeof(Header), 0, first - sizeof(Header));
+    header.level_map = 0;
+    header.cursor = first;
+
+    uint64_t to = first;
+    for (uint64_t block = first; block < header.end;) {
+        uint64_t size = area.size(block);
+        if (area.used(block)) {
+            if (block != to) {
+                std::memmove(static_cast<char *>(_base) + to, static_cast<char *>(_base) + block, size);
+                area.word(area.owner(to)) = to + kHeadSize;
+                header.defrag_bytes += size;
+            }
+            area.tag(to) = size | kUsed | kPrevUsed;
+            to += size;
+        }
+        block += size;
+    }
+
+    if (to < header.end) {
+        area.tag(to) = (header.end - to) | kPrevUsed;
+        area.footer(to);
+        area.link(to);
+        area.tag(header.end) = kUsed;
+    } else {
+        area.tag(header.end) = kUsed | kPrevUsed;
+    }
+
+    header.defrag_runs++;
+    header.defrag_time += Elapsed(start);
+}
+
+/**
+ * Walks blocks from the cursor sliding used ones over the free block in front of them, so the free
+ * block moves towards the end of the area collecting free space. Allocator is consistent between the
+ * steps, block moves that don't fit the budget wait for the next call
+ */
+size_t Simple::defrag(size_t max_bytes, size_t max_time) {
+    Area area(_base);
+    Header &header = area.header();
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::microseconds(max_time);
+
+    size_t moved = 0;
+    bool wrapped = false;
+    for (uint64_t scanned = 1;; scanned++) {
+        uint64_t block = header.cursor;
+        if (block >= header.end) {
+            // Pass is over, the one that finds nothing to move means area is compact
+            header.cursor = area.first();
+            if (moved != 0 || wrapped) {
+                break;
+            }
+            wrapped = true;
+            continue;
+        }
+
+        uint64_t following = block + area.size(block);
+        if (area.used(block) || following == header.end) {
+            header.cursor = following;
+        } else {
+            uint64_t size = area.size(following);
+            if (moved != 0 && max_bytes != 0 && moved + size > max_bytes) {
+                break;
+            }
+            header.cursor = area.slide(block);
+            moved += size;
+            scanned = 0;
+        }
+
+        if (max_time != 0 && scanned % kScanBatch == 0 && std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    header.defrag_steps++;
+    header.defrag_bytes += moved;
+    header.defrag_time += Elapsed(start);
+    return moved;
+}
+
+// See Simple.h
+double Simple::fragmentation() const {
+    Area area(_base);
+    uint64_t available = area.header().end - area.first() - area.header().used;
+    return available == 0 ? 0 : 1 - double(area.largest()) / available;
+}
 
 /**
- * TODO: semantics
+ * Walks all blocks once, so takes time linear in the number of them. Histogram and regions are reported
+ * as they are, values without the unit are bytes
  */
-std::string Simple::dump() const { return ""; }
+std::string Simple::dump() const {
+    Area area(_base);
+    Header &header = area.header();
+    uint64_t first = area.first();
+    uint64_t region = (header.end - first + kDumpRegions - 1) / kDumpRegions;
+
+    uint64_t used_blocks = 0, free_blocks = 0;
+    uint64_t classes[64] = {}, class_bytes[64] = {};
+    uint64_t regions[kDumpRegions] = {};
+    for (uint64_t block = first; block < header.end; block += area.size(block)) {
+        uint64_t size = area.size(block);
+        if (!area.used(block)) {
+            free_blocks++;
+            classes[HighBit(size)]++;
+            class_bytes[HighBit(size)] += size;
+            continue;
+        }
+
+        // Block may span several regions, each gets its part
+        used_blocks++;
+        for (uint64_t from = block, to = block + size; from < to;) {
+            uint64_t index = (from - first) / region;
+            uint64_t border = std::min(to, first + (index + 1) * region);
+            regions[index] += border - from;
+            from = border;
+        }
+    }
+
+    uint64_t handles = ((header.size & ~kFlags) - kTagSize - header.end) / kTagSize, free_handles = 0;
+    for (uint64_t handle = header.handles; handle != 0; handle = area.word(handle) & ~kFreeHandle) {
+        free_handles++;
+    }
+
+    std::string out;
+    auto line = [&out](const std::string &name, const std::string &value) { out += name + " " + value + "\n"; };
+    line("size", std::to_string(header.size));
+    line("used", std::to_string(header.used));
+    line("available", std::to_string(available()));
+    line("largest_free", std::to_string(area.largest()));
+    line("fragmentation", std::to_string(fragmentation()));
+    line("used_blocks", std::to_string(used_blocks));
+    line("free_blocks", std::to_string(free_blocks));
+    for (uint64_t bit = 0; bit < 64; bit++) {
+        if (classes[bit] != 0) {
+            std::string low = std::to_string(uint64_t(1) << bit);
+            line("free_blocks_" + low, std::to_string(classes[bit]));
+            line("free_bytes_" + low, std::to_string(class_bytes[bit]));
+        }
+    }
+    for (uint64_t index = 0; index < kDumpRegions; index++) {
+        uint64_t begin = first + index * region, end = std::min(header.end, begin + region);
+        double utilization = end > begin ? double(regions[index]) / (end - begin) : 0;
+        line("region_" + std::to_string(index) + "_utilization", std::to_string(utilization));
+    }
+    line("handles", std::to_string(handles));
+    line("handles_used", std::to_string(handles - free_handles));
+    line("handles_free", std::to_string(free_handles));
+    line("buddy", std::to_string(header.buddy));
+    line("alloc_failures", std::to_string(header.failures));
+    line("defrag_runs", std::to_string(header.defrag_runs));
+    line("defrag_steps", std::to_string(header.defrag_steps));
+    line("defrag_bytes", std::to_string(header.defrag_bytes));
+    line("defrag_time_us", std::to_string(header.defrag_time));
+    return out;
+}
+
+// See Simple.h
+Pointer Simple::get(size_t offset) const { return Pointer(_base, offset); }
+
+// See Simple.h
+Pointer Simple::at(const void *address) const {
+    Area area(_base);
+    const char *base = static_cast<const char *>(_base);
+    const char *data = static_cast<const char *>(address);
+    if (data < base + area.first() + kHeadSize || data >= base + area.header().end ||
+        (data - base) % kTagSize != 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Address doesn't belong to the area");
+    }
+
+    uint64_t offset = data - base;
+    Pointer p(_base, area.owner(offset - kHeadSize));
+    if (Block(area, p, _base_len) != offset - kHeadSize) {
+        throw AllocError(AllocErrorType::InvalidFree, "Address isn't the beginning of the allocation");
+    }
+    return p;
+}
+
+// See Simple.h
+bool Simple::buddy() const { return Area(_base).header().buddy != 0; }
+
+// See Simple.h
+void Simple::buddy(bool enabled) { Area(_base).header().buddy = enabled ? 1 : 0; }
+
+// See Simple.h
+size_t Simple::root() const { return Area(_base).header().root; }
+
+// See Simple.h
+void Simple::root(const Pointer &p) { Area(_base).header().root = p.offset(); }
+
+// See Simple.h
+size_t Simple::used() const { return Area(_base).header().used; }
+
+// See Simple.h
+size_t Simple::available() const {
+    Area area(_base);
+    return area.header().end - area.first() - area.header().used;
+}
 
 } // namespace Allocator
 } // namespace Afina
@@ -0,0 +1,66 @@
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+const std::size_t SlabCache::kMinSize;
+
+// See SlabCache.h
+SlabCache::SlabCache(Arena &arena) : _arena(arena), _orders(Order(arena.SlabSize())) {}
+
+// See SlabCache.h
+void *SlabCache::Alloc(std::size_t size) {
+    if (Size(size) == 0) {
+        return nullptr;
+    }
+    return Alloc(Order(size), Size(size));
+}
+
+/**
+ * Takes free slab of the order or splits the one of the next order, arena slabs have the top order
+ */
+void *SlabCache::Alloc(std::size_t order, std::size_t size) {
+    if (order == _orders) {
+        return _arena.Alloc();
+    }
+
+    void *slab = _free[order].Pop();
+    if (slab == nullptr) {
+        slab = Alloc(order + 1, size * 2);
+        if (slab != nullptr) {
+            _free[order].Push(static_cast<char *>(slab) + size);
+        }
+    }
+    return slab;
+}
+
+// See SlabCache.h
+void SlabCache::Free(void *slab, std::size_t size) {
+    std::size_t order = Order(size);
+    if (order == _orders) {
+        _arena.Free(slab);
+    } else {
+        _free[order].Push(slab);
+    }
+}
+
+// See SlabCache.h
+std::size_t SlabCache::Size(std::size_t size) const {
+    std::size_t result = kMinSize;
+    while (result < size) {
+        result *= 2;
+    }
+    return result <= _arena.SlabSize() ? result : 0;
+}
+
+// See SlabCache.h
+std::size_t SlabCache::Order(std::size_t size) const {
+    std::size_t order = 0;
+    while ((kMinSize << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+} // namespace Allocator
+} // namespace Afina
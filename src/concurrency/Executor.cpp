@@ -1,5 +1,74 @@
 #include <afina/concurrency/Executor.h>
 
 namespace Afina {
-namespace Concurrency {}
+namespace Concurrency {
+
+// See Executor.h
+void perform(Executor *executor) {
+    std::unique_lock<std::mutex> lock(executor->mutex);
+    while (true) {
+        while (executor->tasks.empty() && executor->state == Executor::State::kRun) {
+            executor->empty_condition.wait(lock);
+        }
+
+        // Pool is stopping and all enqueued jobs are done
+        if (executor->tasks.empty()) {
+            break;
+        }
+
+        std::function<void()> task = std::move(executor->tasks.front());
+        executor->tasks.pop_front();
+
+        lock.unlock();
+        try {
+            task();
+        } catch (...) {
+            // Task failure must not kill the pool
+        }
+        lock.lock();
+    }
+
+    if (--executor->alive == 0) {
+        executor->state = Executor::State::kStopped;
+        executor->stop_condition.notify_all();
+    }
+}
+
+// See Executor.h
+Executor::Executor(std::string name, int size) : state(State::kRun), name(std::move(name)), alive(size) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int i = 0; i < size; i++) {
+        threads.emplace_back(perform, this);
+    }
+}
+
+// See Executor.h
+Executor::~Executor() { Stop(true); }
+
+// See Executor.h
+void Executor::Stop(bool await) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (state == State::kRun) {
+            state = threads.empty() ? State::kStopped : State::kStopping;
+            empty_condition.notify_all();
+        }
+
+        if (!await) {
+            return;
+        }
+
+        while (state != State::kStopped) {
+            stop_condition.wait(lock);
+        }
+    }
+
+    for (std::thread &t : threads) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+} // namespace Concurrency
 } // namespace Afina
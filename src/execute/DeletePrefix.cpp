@@ -0,0 +1,28 @@
+#include <afina/Storage.h>
+#include <afina/execute/DeletePrefix.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// Number of keys removed under single storage call
+static const std::size_t kChunkSize = 256;
+
+void DeletePrefix::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "DeletePrefix(" << _prefix << ")" << std::endl;
+
+    std::size_t total = 0, deleted = 0;
+    do {
+        if (!storage.DeletePrefix(_prefix, kChunkSize, deleted)) {
+            out.assign("SERVER_ERROR storage doesn't support prefix operations");
+            return;
+        }
+        total += deleted;
+    } while (deleted == kChunkSize);
+
+    out = "DELETED " + std::to_string(total);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -29,8 +29,9 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::stringstream outStream;
 
     std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+    for (std::size_t i = 0; i < _keys.size(); i++) {
+        const std::string &key = _keys[i];
+        if (!storage.Get(key, _hashes[i], value))
             continue;
         outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
         outStream << value << "\r\n";
@@ -40,5 +41,31 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     out = outStream.str();
 }
 
+void Get::ExecuteChunks(Storage &storage, const std::string &args,
+                        std::vector<std::shared_ptr<const std::string>> &out) {
+    std::stringstream keyStream;
+    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
+    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
+
+    static const std::shared_ptr<const std::string> crlf(new std::string("\r\n"));
+
+    std::vector<std::shared_ptr<const std::string>> value;
+    for (std::size_t i = 0; i < _keys.size(); i++) {
+        const std::string &key = _keys[i];
+        value.clear();
+        if (!storage.GetChunks(key, _hashes[i], value))
+            continue;
+
+        std::size_t size = 0;
+        for (auto &chunk : value) {
+            size += chunk->size();
+        }
+        out.emplace_back(new std::string("VALUE " + key + " 0 " + std::to_string(size) + "\r\n"));
+        out.insert(out.end(), value.begin(), value.end());
+        out.push_back(crlf);
+    }
+    out.emplace_back(new std::string("END")); // networking layer should add the last \r\n
+}
+
 } // namespace Execute
 } // namespace Afina
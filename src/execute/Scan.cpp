@@ -0,0 +1,83 @@
+#include <afina/Storage.h>
+#include <afina/execute/Scan.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace Afina {
+namespace Execute {
+
+// Maximum number of keys returned at once, bounds time storage is busy with single scan
+static const std::size_t kMaxCount = 1000;
+
+// Cursor is a hex encoded last key returned, so it never clashes with "0" and has no spaces
+static std::string encode_cursor(const std::string &key) {
+    static const char digits[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(key.size() * 2);
+    for (unsigned char c : key) {
+        result.push_back(digits[c >> 4]);
+        result.push_back(digits[c & 0xf]);
+    }
+    return result;
+}
+
+static bool decode_cursor(const std::string &cursor, std::string &key) {
+    key.clear();
+    if (cursor == "0") {
+        return true;
+    }
+    if (cursor.size() % 2 != 0) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < cursor.size(); i += 2) {
+        int value = 0;
+        for (std::size_t j = i; j < i + 2; j++) {
+            char c = cursor[j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value |= c - 'a' + 10;
+            } else {
+                return false;
+            }
+        }
+        key.push_back(static_cast<char>(value));
+    }
+    return true;
+}
+
+void Scan::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Scan(" << _prefix << ", " << _cursor << ", " << _count << ")" << std::endl;
+
+    std::string after;
+    if (!decode_cursor(_cursor, after)) {
+        out.assign("CLIENT_ERROR bad cursor");
+        return;
+    }
+
+    std::size_t count = std::min(_count, kMaxCount);
+    std::vector<std::string> keys;
+    if (!storage.Scan(_prefix, after, count, keys)) {
+        out.assign("SERVER_ERROR storage doesn't support prefix operations");
+        return;
+    }
+
+    std::stringstream outStream;
+    for (auto &key : keys) {
+        outStream << "KEY " << key << "\r\n";
+    }
+
+    // Short portion means there are no more keys
+    outStream << "CURSOR " << ((keys.size() < count || keys.empty()) ? "0" : encode_cursor(keys.back())) << "\r\n";
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
+
+} // namespace Execute
+} // namespace Afina
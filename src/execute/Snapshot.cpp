@@ -0,0 +1,20 @@
+#include <afina/Storage.h>
+#include <afina/execute/Snapshot.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+void Snapshot::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Snapshot()" << std::endl;
+
+    if (storage.Snapshot()) {
+        out = "OK";
+    } else {
+        out = "SERVER_ERROR snapshots aren't configured or one is already in progress";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
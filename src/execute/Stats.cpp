@@ -1,4 +1,5 @@
 #include <afina/Storage.h>
+#include <afina/allocator/Pooled.h>
 #include <afina/execute/Stats.h>
 
 #include <iostream>
@@ -8,7 +9,40 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Upon receiving the "stats" command without arguments, the server sends a number of lines
+which look like this:
+
+STAT <name> <value>\r\n
+
+The server terminates this list with the line
+
+END\r\n
+
+"stats <group>" reports counters of the group in the same way.
+
+*/
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    if (_group.empty()) {
+        storage.Stats(stats);
+    } else if (_group == "allocator") {
+        storage.AllocatorStats(stats);
+    } else {
+        out = "CLIENT_ERROR unknown stats group";
+        return;
+    }
+    Allocator::Pooled::Stats(stats);
+
+    std::stringstream outStream;
+    for (auto &stat : stats) {
+        outStream << "STAT " << stat.first << " " << stat.second << "\r\n";
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
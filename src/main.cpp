@@ -11,6 +11,7 @@
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/allocator/Pooled.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
 
@@ -21,8 +22,16 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/AdaptiveStorage.h"
+#include "storage/CompressedStorage.h"
+#include "storage/LogStorage.h"
+#include "storage/MappedTable.h"
+#include "storage/ShardedLRU.h"
+#include "storage/SharedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SnapshotStorage.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TieredLRU.h"
 
 using namespace Afina;
 
@@ -51,14 +60,124 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        std::string index_type = "map";
+        if (options.count("index") > 0) {
+            index_type = options["index"].as<std::string>();
+        }
+
+        Afina::Backend::IndexType index;
+        if (index_type == "map") {
+            index = Afina::Backend::IndexType::kMap;
+        } else if (index_type == "hash") {
+            index = Afina::Backend::IndexType::kHash;
+        } else if (index_type == "art") {
+            index = Afina::Backend::IndexType::kArt;
+        } else {
+            throw std::runtime_error("Unknown index type");
+        }
+
+        size_t shards = 8;
+        if (options.count("shards") > 0) {
+            shards = options["shards"].as<size_t>();
+        }
+
+        bool filter = options.count("filter") > 0;
+
+        // Pools must get huge pages before the storage takes any memory from them
+        bool huge_pages = options.count("hugepages") > 0;
+        Afina::Allocator::Pooled::HugePages(huge_pages);
+
+        size_t storage_size = 64ul << 20;
+        if (options.count("storage-size") > 0) {
+            storage_size = options["storage-size"].as<size_t>();
+        }
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(storage_size, index, filter);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(storage_size, index, filter);
+        } else if (storage_type == "mt_sharded_lru") {
+            storage = std::make_shared<Afina::Backend::ShardedLRU>(shards, storage_size, index, filter);
+        } else if (storage_type == "mt_tiered_lru") {
+            std::string tier_dir = "/tmp";
+            if (options.count("tier-dir") > 0) {
+                tier_dir = options["tier-dir"].as<std::string>();
+            }
+
+            size_t tier_size = 1ul << 30;
+            if (options.count("tier-size") > 0) {
+                tier_size = options["tier-size"].as<size_t>();
+            }
+            storage = std::make_shared<Afina::Backend::TieredLRU>(storage_size, index, tier_dir, tier_size);
+        } else if (storage_type == "mt_shm_lru") {
+            std::string shm_name = "/afina";
+            if (options.count("shm") > 0) {
+                shm_name = options["shm"].as<std::string>();
+            }
+
+            size_t shm_size = 64ul << 20;
+            if (options.count("shm-size") > 0) {
+                shm_size = options["shm-size"].as<size_t>();
+            }
+            storage = std::make_shared<Afina::Backend::SharedLRU>(shm_name, shm_size, huge_pages,
+                                                                  options.count("shm-buddy") > 0);
+        } else if (storage_type == "mapped_table") {
+            if (options.count("table") == 0) {
+                throw std::runtime_error("Storage mapped_table requires --table");
+            }
+            storage = std::make_shared<Afina::Backend::MappedTable>(options["table"].as<std::string>());
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Monitor wraps storage itself: it only changes the limit and has to see the real one
+        if (options.count("memory-monitor") > 0) {
+            std::string cgroup;
+            if (options.count("cgroup") > 0) {
+                cgroup = options["cgroup"].as<std::string>();
+            }
+            storage = std::make_shared<Afina::Backend::AdaptiveStorage>(storage, storage_size, cgroup);
+        }
+
+        // Compression goes right on top of the storage, so snapshots and log keep plain values
+        if (options.count("compress") > 0) {
+            if (storage_type == "mapped_table") {
+                throw std::runtime_error("Storage mapped_table can't be compressed");
+            }
+            storage = std::make_shared<Afina::Backend::CompressedStorage>(storage, options["compress"].as<size_t>());
+        }
+
+        if (options.count("snapshot") > 0) {
+            size_t period = 0;
+            if (options.count("snapshot-period") > 0) {
+                period = options["snapshot-period"].as<size_t>();
+            }
+
+            snapshot = std::make_shared<Afina::Backend::SnapshotStorage>(
+                storage, options["snapshot"].as<std::string>(), period);
+            storage = snapshot;
+        }
+
+        // Log goes on top of snapshots, so that loading snapshot doesn't get logged
+        if (options.count("log") > 0) {
+            std::string prefix;
+            if (options.count("log-prefix") > 0) {
+                prefix = options["log-prefix"].as<std::string>();
+            }
+
+            size_t window = 1000;
+            if (options.count("log-window") > 0) {
+                window = options["log-window"].as<size_t>();
+            }
+
+            mutation_log =
+                std::make_shared<Afina::Backend::LogStorage>(storage, options["log"].as<std::string>(), prefix, window);
+            storage = mutation_log;
+        }
+
+        // Only thread safe storages could be loaded in parallel
+        load_threads = (storage_type == "st_lru") ? 1 : std::thread::hardware_concurrency();
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
@@ -89,6 +208,23 @@ public:
         log->warn("Start storage");
         storage->Start();
 
+        if (snapshot) {
+            log->warn("Load storage snapshot");
+            try {
+                size_t items = snapshot->Load(load_threads);
+                log->warn("Loaded {} items from snapshot", items);
+            } catch (std::runtime_error &ex) {
+                log->error("Failed to load snapshot: {}", ex.what());
+            }
+        }
+
+        // Log has changes made after the snapshot, so it goes last
+        if (mutation_log) {
+            log->warn("Replay mutation log");
+            size_t records = mutation_log->Replay(load_threads);
+            log->warn("Replayed {} log records", records);
+        }
+
         // TODO: configure network service
         const uint16_t port = 8080;
         log->warn("Start network on {}", port);
@@ -111,6 +247,15 @@ private:
     std::shared_ptr<Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
+
+    // Storage decorator taking care of snapshots, if those are enabled
+    std::shared_ptr<Afina::Backend::SnapshotStorage> snapshot;
+
+    // Storage decorator making changes durable, if log is enabled
+    std::shared_ptr<Afina::Backend::LogStorage> mutation_log;
+
+    // Number of threads loading snapshots on start
+    size_t load_threads = 1;
     std::shared_ptr<Network::Server> server;
 };
 
@@ -131,6 +276,26 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("i,index", "Type of storage index to use", cxxopts::value<std::string>());
+        options.add_options()("storage-size", "Memory limit of LRU storages in bytes", cxxopts::value<size_t>());
+        options.add_options()("shards", "Number of shards in sharded storage", cxxopts::value<size_t>());
+        options.add_options()("tier-dir", "Directory for files of tiered storage", cxxopts::value<std::string>());
+        options.add_options()("tier-size", "Limit of tiered storage files size", cxxopts::value<size_t>());
+        options.add_options()("shm", "Name of shared memory segment for mt_shm_lru", cxxopts::value<std::string>());
+        options.add_options()("shm-size", "Size of shared memory segment", cxxopts::value<size_t>());
+        options.add_options()("shm-buddy", "Round mt_shm_lru items to powers of two for in place appends");
+        options.add_options()("table", "Dataset file for mapped_table storage", cxxopts::value<std::string>());
+        options.add_options()("compress", "Compress values not smaller than given size", cxxopts::value<size_t>());
+        options.add_options()("memory-monitor", "Shrink storage under memory pressure and grow it back");
+        options.add_options()("cgroup", "Directory of cgroup v2 for memory monitor", cxxopts::value<std::string>());
+        options.add_options()("filter", "Check Bloom filter before storage lookup");
+        options.add_options()("hugepages", "Back allocator arenas and shared memory by huge pages");
+        options.add_options()("snapshot", "File to save storage snapshots to and load on start",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-period", "Seconds between periodic snapshots", cxxopts::value<size_t>());
+        options.add_options()("log", "Directory of the mutation log", cxxopts::value<std::string>());
+        options.add_options()("log-prefix", "Log only keys with the prefix", cxxopts::value<std::string>());
+        options.add_options()("log-window", "Log group commit window in microseconds", cxxopts::value<size_t>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
@@ -1,6 +1,8 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -13,6 +15,7 @@
 #include <signal.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <spdlog/logger.h>
@@ -27,6 +30,37 @@ namespace Afina {
 namespace Network {
 namespace STblocking {
 
+// Writes pieces one after another using as few syscalls as possible, throws if connection fails
+static void SendChunks(int socket, const std::vector<std::shared_ptr<const std::string>> &chunks) {
+    std::vector<struct iovec> iov;
+    iov.reserve(chunks.size());
+    for (auto &chunk : chunks) {
+        if (!chunk->empty()) {
+            iov.push_back({const_cast<char *>(chunk->data()), chunk->size()});
+        }
+    }
+
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        ssize_t written = writev(socket, &iov[first], std::min<std::size_t>(iov.size() - first, IOV_MAX));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw std::runtime_error("Failed to send response");
+        }
+
+        // Skip pieces sent entirely, the rest of partially sent one goes next
+        for (; first < iov.size() && std::size_t(written) >= iov[first].iov_len; first++) {
+            written -= iov[first].iov_len;
+        }
+        if (written > 0) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
+    }
+}
+
 // See Server.h
 ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
 
@@ -216,17 +250,15 @@ void ServerImpl::OnRun() {
                     if (command_to_execute && arg_remains == 0) {
                         _logger->debug("Start command execution");
 
-                        std::string result;
+                        std::vector<std::shared_ptr<const std::string>> result;
                         if (argument_for_command.size()) {
                             argument_for_command.resize(argument_for_command.size() - 2);
                         }
-                        command_to_execute->Execute(*pStorage, argument_for_command, result);
+                        command_to_execute->ExecuteChunks(*pStorage, argument_for_command, result);
 
                         // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                            throw std::runtime_error("Failed to send response");
-                        }
+                        result.emplace_back(new std::string("\r\n"));
+                        SendChunks(client_socket, result);
 
                         // Prepare for the next command
                         command_to_execute.reset();
@@ -5,11 +5,13 @@
 
 #include <sys/epoll.h>
 
+#include <afina/allocator/Pooled.h>
+
 namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
-class Connection {
+class Connection : public Allocator::Pooled {
 public:
     Connection(int s) : _socket(s) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
@@ -8,8 +8,11 @@
 #include <afina/execute/Append.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
+#include <afina/execute/DeletePrefix.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Scan.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Snapshot.h>
 #include <afina/execute/Stats.h>
 
 namespace Afina {
@@ -30,9 +33,15 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
                 if (name == "set" || name == "add" || name == "append" || name == "prepend") {
                     state = State::spKey;
+                    hash_keys = true;
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
-                } else if (name == "stats") {
+                    hash_keys = true;
+                } else if (name == "delete_prefix" || name == "scan") {
+                    state = State::sgKey;
+                } else if (name == "stats" && c == ' ') {
+                    state = State::sgKey;
+                } else if (name == "stats" || name == "snapshot") {
                     state = State::sLF;
                     continue;
                 } else {
@@ -47,17 +56,17 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spKey: {
             if (c == ' ') {
                 state = State::spFlags;
-                keys.push_back(curKey);
+                PushKey();
                 // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
             } else {
-                curKey.push_back(c);
+                pos = ScanKey(input, pos, size) - 1;
             }
             break;
         }
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
+                PushKey();
                 // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
 
                 if (keys.size() == 0) {
@@ -69,10 +78,10 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             } else if (c == ' ') {
                 // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
                 state = State::sgKey;
-                keys.push_back(curKey);
+                PushKey();
                 curKey.clear();
             } else {
-                curKey.push_back(c);
+                pos = ScanKey(input, pos, size) - 1;
             }
             break;
         }
@@ -169,15 +178,42 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
 
     body_size = bytes;
     if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
+        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime, hashes[0]));
     } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
+        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime, hashes[0]));
     } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
+        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime, hashes[0]));
     } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+        return std::unique_ptr<Execute::Command>(new Execute::Get(keys, hashes));
+    } else if (name == "delete_prefix") {
+        if (keys.size() != 1) {
+            throw std::runtime_error("Command delete_prefix expects exactly one prefix");
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::DeletePrefix(keys[0]));
+    } else if (name == "scan") {
+        if (keys.size() != 3 || keys[2].empty()) {
+            throw std::runtime_error("Command scan expects prefix, cursor and count");
+        }
+
+        size_t count = 0;
+        for (char c : keys[2]) {
+            if (c < '0' || c > '9') {
+                throw std::runtime_error("Scan count must be a number");
+            }
+            size_t n = (count * 10) + (c - '0');
+            if (n < count) {
+                throw std::runtime_error("Scan count field overflow");
+            }
+            count = n;
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::Scan(keys[0], keys[1], count));
     } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
+        if (keys.size() > 1) {
+            throw std::runtime_error("Command stats expects at most one group");
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::Stats(keys.empty() ? "" : keys[0]));
+    } else if (name == "snapshot") {
+        return std::unique_ptr<Execute::Command>(new Execute::Snapshot());
     } else {
         throw std::runtime_error("Unsupported command");
     }
@@ -188,12 +224,39 @@ void Parser::Reset() {
     state = State::sName;
     name.clear();
     keys.clear();
+    hashes.clear();
     curKey.clear();
+    hash_keys = false;
+    curHash.Reset();
     parse_complete = false;
     flags = 0;
     bytes = 0;
     exprtime = 0;
 }
 
+// See Parse.h
+size_t Parser::ScanKey(const char *input, size_t pos, size_t size) {
+    // Only space ends the key of update command, the one of retrieval command may be the last token
+    size_t end = pos;
+    while (end < size && input[end] != ' ' && (input[end] != '\r' || state == State::spKey)) {
+        end++;
+    }
+
+    curKey.append(input + pos, end - pos);
+    if (hash_keys) {
+        curHash.Update(input + pos, end - pos);
+    }
+    return end;
+}
+
+// See Parse.h
+void Parser::PushKey() {
+    if (hash_keys) {
+        hashes.push_back(curHash.Finish());
+        curHash.Reset();
+    }
+    keys.push_back(curKey);
+}
+
 } // namespace Protocol
 } // namespace Afina
@@ -8,6 +8,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <afina/KeyHash.h>
+
 namespace Afina {
 namespace Execute {
 class Command;
@@ -17,6 +19,10 @@ namespace Protocol {
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
+ *
+ * Keys of get and update commands get hashed with KeyHash while their bytes are scanned, and the hash
+ * travels in the command down to storage, so that no layer hashes the key again. Other tokens (prefixes,
+ * scan arguments, stats groups) aren't hashed
  */
 class Parser {
 public:
@@ -70,6 +76,7 @@ private:
     // vrious fields of the command
     std::string name;
     std::vector<std::string> keys;
+    std::vector<uint64_t> hashes;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -91,6 +98,17 @@ private:
     bool negative;
     std::string curKey;
     bool parse_complete;
+
+    // Whether tokens of the command are keys which need hash, and hash of the key being read
+    bool hash_keys;
+    KeyHash::Stream curHash;
+
+    // Appends bytes of the key starting at the given position to the current one, returns position of
+    // the byte ending the key or size if key continues in the next input
+    size_t ScanKey(const char *input, size_t pos, size_t size);
+
+    // Completes current key
+    void PushKey();
 };
 
 } // namespace Protocol
@@ -0,0 +1,249 @@
+#include "AdaptiveStorage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Usage above this part of the limit shrinks budget, usage below the other one lets it grow
+const uint64_t kHighPercent = 90;
+const uint64_t kLowPercent = 75;
+
+// PSI avg10 shrinking budget regardless of usage, and the one budget is allowed to grow below
+const double kPressureHigh = 10.0;
+const double kPressureLow = 1.0;
+
+// Budget changes at least by this part of itself, and never goes below this part of the max size
+const std::size_t kStepDivisor = 10;
+const std::size_t kFloorDivisor = 10;
+
+bool ReadFile(const std::string &path, std::string &content) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+// Reads file holding single number, "max" means no limit and turns into 0
+bool ReadNumber(const std::string &path, uint64_t &value) {
+    std::string content;
+    if (!ReadFile(path, content)) {
+        return false;
+    }
+    if (content.compare(0, 3, "max") == 0) {
+        value = 0;
+        return true;
+    }
+    unsigned long long number;
+    if (std::sscanf(content.c_str(), "%llu", &number) != 1) {
+        return false;
+    }
+    value = number;
+    return true;
+}
+
+// Returns field of /proc/meminfo in bytes, 0 if it is missing
+uint64_t MemInfo(const char *field) {
+    std::ifstream file("/proc/meminfo");
+    std::string line;
+    std::size_t length = std::strlen(field);
+    while (std::getline(file, line)) {
+        unsigned long long kb;
+        if (line.compare(0, length, field) == 0 && line.size() > length && line[length] == ':' &&
+            std::sscanf(line.c_str() + length + 1, "%llu", &kb) == 1) {
+            return uint64_t(kb) << 10;
+        }
+    }
+    return 0;
+}
+
+// Reads avg10 of the "some" line of the PSI file
+bool ReadPressure(const std::string &path, double &avg10) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (std::sscanf(line.c_str(), "some avg10=%lf", &avg10) == 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Directory of the cgroup v2 process belongs to, empty if there is none
+std::string FindCgroup() {
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            return "/sys/fs/cgroup" + line.substr(3);
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+// See AdaptiveStorage.h
+AdaptiveStorage::AdaptiveStorage(std::shared_ptr<Afina::Storage> storage, std::size_t max_size,
+                                 const std::string &cgroup, std::size_t period)
+    : _storage(std::move(storage)), _cgroup(cgroup.empty() ? FindCgroup() : cgroup), _period(period),
+      _running(false), _max_size(max_size), _budget(max_size), _last_decision("none"), _shrinks(0), _grows(0) {}
+
+// See AdaptiveStorage.h
+AdaptiveStorage::~AdaptiveStorage() { Stop(); }
+
+// See AdaptiveStorage.h
+void AdaptiveStorage::Start() {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_running) {
+        return;
+    }
+
+    _storage->Start();
+    _running = true;
+    if (_period > 0) {
+        _timer = std::thread(&AdaptiveStorage::OnTimer, this);
+    }
+}
+
+// See AdaptiveStorage.h
+void AdaptiveStorage::Stop() {
+    std::unique_lock<std::mutex> lock(_lock);
+    bool running = _running;
+    _running = false;
+    _state_changed.notify_all();
+
+    lock.unlock();
+    if (_timer.joinable()) {
+        _timer.join();
+    }
+
+    if (running) {
+        _storage->Stop();
+    }
+}
+
+// See AdaptiveStorage.h
+bool AdaptiveStorage::Resize(std::size_t max_size) {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_storage->Resize(std::min(_budget, max_size))) {
+        return false;
+    }
+    _max_size = max_size;
+    _budget = std::min(_budget, max_size);
+    return true;
+}
+
+// See AdaptiveStorage.h
+void AdaptiveStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+
+    std::unique_lock<std::mutex> lock(_lock);
+    char pressure[32];
+    std::snprintf(pressure, sizeof(pressure), "%.2f", _last.pressure);
+
+    stats.emplace_back("memory_source", _last.source);
+    stats.emplace_back("memory_limit", std::to_string(_last.limit));
+    stats.emplace_back("memory_usage", std::to_string(_last.usage));
+    stats.emplace_back("memory_pressure_avg10", pressure);
+    stats.emplace_back("memory_budget", std::to_string(_budget));
+    stats.emplace_back("memory_max_budget", std::to_string(_max_size));
+    stats.emplace_back("memory_shrinks", std::to_string(_shrinks));
+    stats.emplace_back("memory_grows", std::to_string(_grows));
+    stats.emplace_back("memory_last_decision", _last_decision);
+}
+
+// See AdaptiveStorage.h
+std::size_t AdaptiveStorage::Check() {
+    Sample sample = Measure();
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _last = sample;
+    if (sample.limit == 0) {
+        _last_decision = "unknown";
+        return _budget;
+    }
+
+    uint64_t high = sample.limit / 100 * kHighPercent;
+    uint64_t low = sample.limit / 100 * kLowPercent;
+    std::size_t floor = _max_size / kFloorDivisor;
+    std::size_t budget = _budget;
+    const char *decision = "hold";
+    if (sample.usage > high || sample.pressure >= kPressureHigh) {
+        // Usage above the limit tells how much has to go, pressure alone only the direction
+        std::size_t over = sample.usage > high ? sample.usage - high : 0;
+        std::size_t step = std::max(over, _budget / kStepDivisor);
+        budget = _budget > floor + step ? _budget - step : floor;
+        decision = "shrink";
+    } else if (sample.usage < low && sample.pressure < kPressureLow && _budget < _max_size) {
+        // Grow carefully: filling the storage raises usage, so only half of the room is taken
+        std::size_t step = std::min<uint64_t>((low - sample.usage) / 2, _max_size / kStepDivisor);
+        budget = std::min(_budget + step, _max_size);
+        decision = "grow";
+    }
+
+    if (budget != _budget) {
+        if (!_storage->Resize(budget)) {
+            _last_decision = "unsupported";
+            return _budget;
+        }
+        if (budget < _budget) {
+            _shrinks++;
+        } else {
+            _grows++;
+        }
+        _budget = budget;
+    }
+    _last_decision = decision;
+    return _budget;
+}
+
+// See AdaptiveStorage.h
+AdaptiveStorage::Sample AdaptiveStorage::Measure() const {
+    Sample sample;
+    if (!_cgroup.empty() && ReadNumber(_cgroup + "/memory.current", sample.usage) &&
+        ReadNumber(_cgroup + "/memory.max", sample.limit)) {
+        sample.source = "cgroup";
+        if (sample.limit == 0) {
+            sample.limit = MemInfo("MemTotal");
+        }
+    } else {
+        std::ifstream statm("/proc/self/statm");
+        uint64_t pages = 0, resident = 0;
+        if (statm >> pages >> resident) {
+            sample.source = "rss";
+            sample.usage = resident * sysconf(_SC_PAGESIZE);
+            sample.limit = sample.usage + MemInfo("MemAvailable");
+        }
+    }
+
+    if (_cgroup.empty() || !ReadPressure(_cgroup + "/memory.pressure", sample.pressure)) {
+        ReadPressure("/proc/pressure/memory", sample.pressure);
+    }
+    return sample;
+}
+
+// See AdaptiveStorage.h
+void AdaptiveStorage::OnTimer() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_state_changed.wait_for(lock, std::chrono::milliseconds(_period), [this] { return !_running; })) {
+        lock.unlock();
+        Check();
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
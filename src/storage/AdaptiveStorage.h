@@ -0,0 +1,187 @@
+#ifndef AFINA_STORAGE_ADAPTIVE_STORAGE_H
+#define AFINA_STORAGE_ADAPTIVE_STORAGE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Memory pressure aware sizing
+ * Decorates another storage watching memory of the process and changing storage limit at runtime:
+ * budget shrinks while memory is close to the limit or the kernel reports memory pressure, so that
+ * cache evicts in batches before the process gets killed by OOM, and grows back up to the configured
+ * size once memory is available again.
+ *
+ * Usage and limit come from cgroup v2 files memory.current and memory.max. Without cgroup usage is
+ * RSS of the process and limit is RSS plus memory available in the system. Pressure is avg10 of the
+ * "some" line of PSI, from the cgroup memory.pressure or /proc/pressure/memory.
+ *
+ * Decorated storage must support Resize, otherwise decorator only reports what it sees.
+ */
+class AdaptiveStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to decorate
+     * @param max_size configured storage limit, budget never grows above it
+     * @param cgroup directory of the cgroup v2, empty to find one of the process
+     * @param period between checks in milliseconds, 0 disables periodic checks
+     */
+    AdaptiveStorage(std::shared_ptr<Afina::Storage> storage, std::size_t max_size, const std::string &cgroup = "",
+                    std::size_t period = 1000);
+    ~AdaptiveStorage();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return _storage->Put(key, value); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return _storage->Set(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        return _storage->GetChunks(key, chunks);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override { return _storage->Append(key, data); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override {
+        return _storage->Put(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override {
+        return _storage->PutIfAbsent(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override {
+        return _storage->Set(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override {
+        return _storage->Get(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        return _storage->GetChunks(key, hash, chunks);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override {
+        return _storage->Append(key, hash, data);
+    }
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override {
+        return _storage->Scan(prefix, after, count, keys);
+    }
+
+    // Implements Afina::Storage interface
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override {
+        return _storage->DeletePrefix(prefix, count, deleted);
+    }
+
+    // Implements Afina::Storage interface, given size becomes the new upper bound of the budget
+    bool Resize(std::size_t max_size) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    void AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        _storage->AllocatorStats(stats);
+    }
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override { return _storage->Fork(); }
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override {
+        return _storage->Dump(visit);
+    }
+
+    // Implements Afina::Storage interface
+    bool Snapshot() override { return _storage->Snapshot(); }
+
+    /**
+     * Takes one sample of the memory state and adjusts storage budget, returns the budget
+     */
+    std::size_t Check();
+
+private:
+    // Memory state seen by the last check
+    struct Sample {
+        // Where numbers come from: cgroup, rss or none if nothing could be read
+        const char *source = "none";
+        uint64_t usage = 0;
+        uint64_t limit = 0;
+        double pressure = 0;
+    };
+
+    Sample Measure() const;
+
+    // Body of the thread doing periodic checks
+    void OnTimer();
+
+    std::shared_ptr<Afina::Storage> _storage;
+
+    std::string _cgroup;
+
+    std::size_t _period;
+
+    // Guards all fields below
+    std::mutex _lock;
+
+    // Notified when _running changes
+    std::condition_variable _state_changed;
+
+    bool _running;
+
+    std::thread _timer;
+
+    std::size_t _max_size;
+
+    // Limit storage has now
+    std::size_t _budget;
+
+    Sample _last;
+    const char *_last_decision;
+
+    uint64_t _shrinks;
+    uint64_t _grows;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ADAPTIVE_STORAGE_H
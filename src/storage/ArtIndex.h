@@ -0,0 +1,788 @@
+#ifndef AFINA_STORAGE_ART_INDEX_H
+#define AFINA_STORAGE_ART_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Index.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Adaptive radix tree index
+ * Keys are split into bytes, each inner node of the tree dispatches on one byte of the key. Node
+ * size adapts to the number of children: 4, 16, 48 and 256 slots. Chains of nodes with a single
+ * child are collapsed into a prefix stored in the node (path compression) and subtrees with a
+ * single key are replaced by the pointer to the entry itself (lazy expansion).
+ *
+ * Index doesn't copy keys: only first kMaxPrefix bytes of compressed path are stored in node,
+ * the rest is taken from the keys of entries whenever needed. So memory per key doesn't depend on
+ * the key length, and shared prefixes are compared once per lookup.
+ *
+ * Children are kept ordered by the key byte, so tree allows ordered and prefix walks, see Walk.
+ */
+template <typename T> class ArtIndex : public Index<T> {
+public:
+    ArtIndex() : _root(0), _size(0), _bytes(0) {}
+    ~ArtIndex() { Clear(); }
+
+    // See Index.h
+    T *Find(const std::string &key) override {
+        uintptr_t cur = _root;
+        std::size_t depth = 0;
+        while (cur != 0) {
+            if (IsLeaf(cur)) {
+                T *leaf = ToLeaf(cur);
+                return (leaf->key == key) ? leaf : nullptr;
+            }
+
+            node *n = ToNode(cur);
+            if (n->prefix_len > 0) {
+                // Optimistic check, bytes beyond kMaxPrefix are verified by the final key comparison
+                if (key.size() < depth + n->prefix_len) {
+                    return nullptr;
+                }
+
+                std::size_t stored = std::min<std::size_t>(n->prefix_len, kMaxPrefix);
+                if (std::memcmp(n->prefix, key.data() + depth, stored) != 0) {
+                    return nullptr;
+                }
+                depth += n->prefix_len;
+            }
+
+            if (depth == key.size()) {
+                return (n->terminal != nullptr && n->terminal->key == key) ? n->terminal : nullptr;
+            }
+
+            uintptr_t *child = FindChild(n, key[depth]);
+            if (child == nullptr) {
+                return nullptr;
+            }
+            cur = *child;
+            depth++;
+        }
+        return nullptr;
+    }
+
+    // See Index.h
+    void Insert(T *entry) override {
+        Insert(_root, entry, 0);
+        _size++;
+    }
+
+    // See Index.h
+    T *Erase(const std::string &key) override {
+        T *result = Erase(_root, key, 0);
+        if (result != nullptr) {
+            _size--;
+        }
+        return result;
+    }
+
+    // See Index.h
+    void Clear() override {
+        Destroy(_root);
+        _root = 0;
+        _size = 0;
+    }
+
+    // See Index.h
+    std::size_t Size() const override { return _size; }
+
+    // See Index.h
+    bool Walk(const std::string &prefix, const std::string &after, const std::function<bool(T *)> &visit) override {
+        const std::string &bound = (after > prefix) ? after : prefix;
+        Walk(_root, 0, true, bound, prefix, after, visit);
+        return true;
+    }
+
+    // See Index.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) const override {
+        stats.emplace_back("index_type", "art");
+        stats.emplace_back("index_bytes", std::to_string(_bytes));
+        stats.emplace_back("index_nodes4", std::to_string(_nodes[kNode4]));
+        stats.emplace_back("index_nodes16", std::to_string(_nodes[kNode16]));
+        stats.emplace_back("index_nodes48", std::to_string(_nodes[kNode48]));
+        stats.emplace_back("index_nodes256", std::to_string(_nodes[kNode256]));
+    }
+
+private:
+    // Number of compressed path bytes stored in the node itself
+    static constexpr std::size_t kMaxPrefix = 10;
+
+    enum Type : uint8_t { kNode4, kNode16, kNode48, kNode256 };
+
+    // Common header of inner nodes. Key which ends exactly after the node prefix is stored in
+    // terminal, it is smaller than any key in the children
+    struct node {
+        Type type;
+        uint16_t count;
+        uint32_t prefix_len;
+        uint8_t prefix[kMaxPrefix];
+        T *terminal;
+    };
+
+    // Children references are tagged pointers: either node or entry with the lowest bit set
+    struct node4 : node {
+        uint8_t keys[4];
+        uintptr_t children[4];
+    };
+
+    struct node16 : node {
+        uint8_t keys[16];
+        uintptr_t children[16];
+    };
+
+    // Children are in arbitrary slots, index maps key byte to slot + 1
+    struct node48 : node {
+        uint8_t index[256];
+        uintptr_t children[48];
+    };
+
+    struct node256 : node {
+        uintptr_t children[256];
+    };
+
+    static inline bool IsLeaf(uintptr_t ref) { return (ref & 1) != 0; }
+    static inline T *ToLeaf(uintptr_t ref) { return reinterpret_cast<T *>(ref & ~uintptr_t(1)); }
+    static inline node *ToNode(uintptr_t ref) { return reinterpret_cast<node *>(ref); }
+    static inline uintptr_t FromLeaf(T *leaf) { return reinterpret_cast<uintptr_t>(leaf) | 1; }
+    static inline uintptr_t FromNode(node *n) { return reinterpret_cast<uintptr_t>(n); }
+
+    template <typename N> N *NewNode(Type type) {
+        N *result = new N;
+        std::memset(static_cast<void *>(result), 0, sizeof(N));
+        result->type = type;
+        _bytes += sizeof(N);
+        _nodes[type]++;
+        return result;
+    }
+
+    void FreeNode(node *n) {
+        _nodes[n->type]--;
+        switch (n->type) {
+        case kNode4:
+            _bytes -= sizeof(node4);
+            delete static_cast<node4 *>(n);
+            break;
+        case kNode16:
+            _bytes -= sizeof(node16);
+            delete static_cast<node16 *>(n);
+            break;
+        case kNode48:
+            _bytes -= sizeof(node48);
+            delete static_cast<node48 *>(n);
+            break;
+        case kNode256:
+            _bytes -= sizeof(node256);
+            delete static_cast<node256 *>(n);
+            break;
+        }
+    }
+
+    // Copies header of the node, used when node changes its size
+    static void CopyHeader(node *to, const node *from) {
+        to->count = from->count;
+        to->prefix_len = from->prefix_len;
+        std::memcpy(to->prefix, from->prefix, kMaxPrefix);
+        to->terminal = from->terminal;
+    }
+
+    // Returns address of the child reference for the given byte or nullptr
+    static uintptr_t *FindChild(node *n, uint8_t c) {
+        switch (n->type) {
+        case kNode4: {
+            node4 *p = static_cast<node4 *>(n);
+            for (int i = 0; i < p->count; i++) {
+                if (p->keys[i] == c) {
+                    return &p->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case kNode16: {
+            node16 *p = static_cast<node16 *>(n);
+#ifdef __SSE2__
+            // Compare byte against all 16 keys at once, mask out slots beyond count
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(c)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(p->keys)));
+            int mask = _mm_movemask_epi8(cmp) & ((1 << p->count) - 1);
+            if (mask != 0) {
+                return &p->children[__builtin_ctz(mask)];
+            }
+#else
+            for (int i = 0; i < p->count; i++) {
+                if (p->keys[i] == c) {
+                    return &p->children[i];
+                }
+            }
+#endif
+            return nullptr;
+        }
+        case kNode48: {
+            node48 *p = static_cast<node48 *>(n);
+            return (p->index[c] != 0) ? &p->children[p->index[c] - 1] : nullptr;
+        }
+        case kNode256: {
+            node256 *p = static_cast<node256 *>(n);
+            return (p->children[c] != 0) ? &p->children[c] : nullptr;
+        }
+        }
+        return nullptr;
+    }
+
+    // Inserts child into sorted arrays of node4/node16 which has a free slot
+    template <typename N> static void AddSorted(N *n, uint8_t c, uintptr_t child) {
+        int pos = 0;
+        while (pos < n->count && n->keys[pos] < c) {
+            pos++;
+        }
+        std::memmove(n->keys + pos + 1, n->keys + pos, n->count - pos);
+        std::memmove(n->children + pos + 1, n->children + pos, (n->count - pos) * sizeof(uintptr_t));
+        n->keys[pos] = c;
+        n->children[pos] = child;
+        n->count++;
+    }
+
+    // Adds new child into node referenced by ref, node gets replaced by the bigger one if it is full
+    void AddChild(uintptr_t &ref, uint8_t c, uintptr_t child) {
+        node *n = ToNode(ref);
+        switch (n->type) {
+        case kNode4: {
+            node4 *p = static_cast<node4 *>(n);
+            if (p->count < 4) {
+                AddSorted(p, c, child);
+                return;
+            }
+
+            node16 *bigger = NewNode<node16>(kNode16);
+            CopyHeader(bigger, p);
+            std::memcpy(bigger->keys, p->keys, 4);
+            std::memcpy(bigger->children, p->children, 4 * sizeof(uintptr_t));
+            FreeNode(p);
+            ref = FromNode(bigger);
+            AddSorted(bigger, c, child);
+            return;
+        }
+        case kNode16: {
+            node16 *p = static_cast<node16 *>(n);
+            if (p->count < 16) {
+                AddSorted(p, c, child);
+                return;
+            }
+
+            node48 *bigger = NewNode<node48>(kNode48);
+            CopyHeader(bigger, p);
+            for (int i = 0; i < 16; i++) {
+                bigger->children[i] = p->children[i];
+                bigger->index[p->keys[i]] = i + 1;
+            }
+            FreeNode(p);
+            ref = FromNode(bigger);
+            AddChild(ref, c, child);
+            return;
+        }
+        case kNode48: {
+            node48 *p = static_cast<node48 *>(n);
+            if (p->count < 48) {
+                int slot = 0;
+                while (p->children[slot] != 0) {
+                    slot++;
+                }
+                p->children[slot] = child;
+                p->index[c] = slot + 1;
+                p->count++;
+                return;
+            }
+
+            node256 *bigger = NewNode<node256>(kNode256);
+            CopyHeader(bigger, p);
+            for (int i = 0; i < 256; i++) {
+                if (p->index[i] != 0) {
+                    bigger->children[i] = p->children[p->index[i] - 1];
+                }
+            }
+            FreeNode(p);
+            ref = FromNode(bigger);
+            AddChild(ref, c, child);
+            return;
+        }
+        case kNode256: {
+            node256 *p = static_cast<node256 *>(n);
+            p->children[c] = child;
+            p->count++;
+            return;
+        }
+        }
+    }
+
+    // Removes child from the node referenced by ref, node gets replaced by the smaller one if it
+    // becomes sparse, or collapsed into its single child
+    void RemoveChild(uintptr_t &ref, uint8_t c) {
+        node *n = ToNode(ref);
+        switch (n->type) {
+        case kNode4:
+        case kNode16: {
+            uint8_t *keys = (n->type == kNode4) ? static_cast<node4 *>(n)->keys : static_cast<node16 *>(n)->keys;
+            uintptr_t *children =
+                (n->type == kNode4) ? static_cast<node4 *>(n)->children : static_cast<node16 *>(n)->children;
+
+            int pos = 0;
+            while (keys[pos] != c) {
+                pos++;
+            }
+            std::memmove(keys + pos, keys + pos + 1, n->count - pos - 1);
+            std::memmove(children + pos, children + pos + 1, (n->count - pos - 1) * sizeof(uintptr_t));
+            n->count--;
+            break;
+        }
+        case kNode48: {
+            node48 *p = static_cast<node48 *>(n);
+            p->children[p->index[c] - 1] = 0;
+            p->index[c] = 0;
+            p->count--;
+            break;
+        }
+        case kNode256: {
+            node256 *p = static_cast<node256 *>(n);
+            p->children[c] = 0;
+            p->count--;
+            break;
+        }
+        }
+        Shrink(ref);
+    }
+
+    // Replaces node by the smaller one if number of children allows
+    void Shrink(uintptr_t &ref) {
+        node *n = ToNode(ref);
+        switch (n->type) {
+        case kNode4:
+            Collapse(ref);
+            return;
+        case kNode16: {
+            node16 *p = static_cast<node16 *>(n);
+            if (p->count > 3) {
+                return;
+            }
+
+            node4 *smaller = NewNode<node4>(kNode4);
+            CopyHeader(smaller, p);
+            std::memcpy(smaller->keys, p->keys, p->count);
+            std::memcpy(smaller->children, p->children, p->count * sizeof(uintptr_t));
+            FreeNode(p);
+            ref = FromNode(smaller);
+            return;
+        }
+        case kNode48: {
+            node48 *p = static_cast<node48 *>(n);
+            if (p->count > 12) {
+                return;
+            }
+
+            node16 *smaller = NewNode<node16>(kNode16);
+            CopyHeader(smaller, p);
+            smaller->count = 0;
+            for (int i = 0; i < 256; i++) {
+                if (p->index[i] != 0) {
+                    smaller->keys[smaller->count] = i;
+                    smaller->children[smaller->count++] = p->children[p->index[i] - 1];
+                }
+            }
+            FreeNode(p);
+            ref = FromNode(smaller);
+            return;
+        }
+        case kNode256: {
+            node256 *p = static_cast<node256 *>(n);
+            if (p->count > 37) {
+                return;
+            }
+
+            node48 *smaller = NewNode<node48>(kNode48);
+            CopyHeader(smaller, p);
+            smaller->count = 0;
+            for (int i = 0; i < 256; i++) {
+                if (p->children[i] != 0) {
+                    smaller->children[smaller->count] = p->children[i];
+                    smaller->index[i] = ++smaller->count;
+                }
+            }
+            FreeNode(p);
+            ref = FromNode(smaller);
+            return;
+        }
+        }
+    }
+
+    // Collapses node4 which has no more than one key left in the subtree
+    void Collapse(uintptr_t &ref) {
+        node4 *n = static_cast<node4 *>(ToNode(ref));
+        if (n->count == 0) {
+            ref = (n->terminal != nullptr) ? FromLeaf(n->terminal) : 0;
+            FreeNode(n);
+            return;
+        }
+
+        if (n->count > 1 || n->terminal != nullptr) {
+            return;
+        }
+
+        // Single child left: merge node prefix, key byte and child prefix into the child
+        uintptr_t child = n->children[0];
+        if (!IsLeaf(child)) {
+            node *c = ToNode(child);
+            uint8_t prefix[kMaxPrefix];
+            std::size_t len = std::min<std::size_t>(n->prefix_len, kMaxPrefix);
+            std::memcpy(prefix, n->prefix, len);
+            if (len < kMaxPrefix) {
+                prefix[len++] = n->keys[0];
+            }
+
+            std::size_t tail = std::min<std::size_t>(c->prefix_len, kMaxPrefix - len);
+            std::memcpy(prefix + len, c->prefix, tail);
+
+            c->prefix_len += n->prefix_len + 1;
+            std::memcpy(c->prefix, prefix, kMaxPrefix);
+        }
+
+        ref = child;
+        FreeNode(n);
+    }
+
+    // Returns entry with the smallest key in the subtree
+    static T *Minimum(uintptr_t ref) {
+        while (!IsLeaf(ref)) {
+            node *n = ToNode(ref);
+            if (n->terminal != nullptr) {
+                return n->terminal;
+            }
+
+            switch (n->type) {
+            case kNode4:
+                ref = static_cast<node4 *>(n)->children[0];
+                break;
+            case kNode16:
+                ref = static_cast<node16 *>(n)->children[0];
+                break;
+            case kNode48: {
+                node48 *p = static_cast<node48 *>(n);
+                int i = 0;
+                while (p->index[i] == 0) {
+                    i++;
+                }
+                ref = p->children[p->index[i] - 1];
+                break;
+            }
+            case kNode256: {
+                node256 *p = static_cast<node256 *>(n);
+                int i = 0;
+                while (p->children[i] == 0) {
+                    i++;
+                }
+                ref = p->children[i];
+                break;
+            }
+            }
+        }
+        return ToLeaf(ref);
+    }
+
+    // Returns number of bytes of the node prefix which match key starting from depth
+    std::size_t PrefixMismatch(uintptr_t ref, const std::string &key, std::size_t depth) {
+        node *n = ToNode(ref);
+        std::size_t limit = std::min<std::size_t>(n->prefix_len, key.size() - depth);
+        std::size_t stored = std::min<std::size_t>(limit, kMaxPrefix);
+
+        std::size_t i = 0;
+        for (; i < stored; i++) {
+            if (n->prefix[i] != static_cast<uint8_t>(key[depth + i])) {
+                return i;
+            }
+        }
+
+        // Rest of prefix isn't in the node, any key in the subtree has it
+        if (i < limit) {
+            const std::string &full = Minimum(ref)->key;
+            for (; i < limit; i++) {
+                if (full[depth + i] != key[depth + i]) {
+                    return i;
+                }
+            }
+        }
+        return i;
+    }
+
+    // Places entry into the new node either as a terminal or as a child
+    void AddLeaf(uintptr_t &ref, T *leaf, std::size_t depth) {
+        if (leaf->key.size() == depth) {
+            ToNode(ref)->terminal = leaf;
+        } else {
+            AddChild(ref, leaf->key[depth], FromLeaf(leaf));
+        }
+    }
+
+    void Insert(uintptr_t &ref, T *leaf, std::size_t depth) {
+        const std::string &key = leaf->key;
+        if (ref == 0) {
+            ref = FromLeaf(leaf);
+            return;
+        }
+
+        // Lazy expansion: replace single entry by the node splitting both keys
+        if (IsLeaf(ref)) {
+            T *other = ToLeaf(ref);
+            const std::string &okey = other->key;
+
+            std::size_t i = depth;
+            while (i < key.size() && i < okey.size() && key[i] == okey[i]) {
+                i++;
+            }
+
+            node4 *n = NewNode<node4>(kNode4);
+            n->prefix_len = i - depth;
+            std::memcpy(n->prefix, key.data() + depth, std::min<std::size_t>(n->prefix_len, kMaxPrefix));
+
+            ref = FromNode(n);
+            AddLeaf(ref, other, i);
+            AddLeaf(ref, leaf, i);
+            return;
+        }
+
+        node *n = ToNode(ref);
+        if (n->prefix_len > 0) {
+            std::size_t p = PrefixMismatch(ref, key, depth);
+            if (p < n->prefix_len) {
+                // Split compressed path: new node takes matched part of prefix
+                node4 *split = NewNode<node4>(kNode4);
+                split->prefix_len = p;
+                std::memcpy(split->prefix, key.data() + depth, std::min<std::size_t>(p, kMaxPrefix));
+
+                // Old node keeps the part after mismatched byte
+                uint8_t c;
+                std::size_t rest = n->prefix_len - p - 1;
+                if (n->prefix_len <= kMaxPrefix) {
+                    c = n->prefix[p];
+                    std::memmove(n->prefix, n->prefix + p + 1, rest);
+                } else {
+                    const std::string &full = Minimum(ref)->key;
+                    c = full[depth + p];
+                    std::memcpy(n->prefix, full.data() + depth + p + 1, std::min<std::size_t>(rest, kMaxPrefix));
+                }
+                n->prefix_len = rest;
+
+                uintptr_t old = ref;
+                ref = FromNode(split);
+                AddChild(ref, c, old);
+                AddLeaf(ref, leaf, depth + p);
+                return;
+            }
+            depth += n->prefix_len;
+        }
+
+        if (depth == key.size()) {
+            n->terminal = leaf;
+            return;
+        }
+
+        uintptr_t *child = FindChild(n, key[depth]);
+        if (child != nullptr) {
+            Insert(*child, leaf, depth + 1);
+        } else {
+            AddChild(ref, key[depth], FromLeaf(leaf));
+        }
+    }
+
+    T *Erase(uintptr_t &ref, const std::string &key, std::size_t depth) {
+        if (ref == 0) {
+            return nullptr;
+        }
+
+        if (IsLeaf(ref)) {
+            T *leaf = ToLeaf(ref);
+            if (leaf->key != key) {
+                return nullptr;
+            }
+            ref = 0;
+            return leaf;
+        }
+
+        node *n = ToNode(ref);
+        if (n->prefix_len > 0) {
+            if (key.size() < depth + n->prefix_len ||
+                std::memcmp(n->prefix, key.data() + depth, std::min<std::size_t>(n->prefix_len, kMaxPrefix)) != 0) {
+                return nullptr;
+            }
+            depth += n->prefix_len;
+        }
+
+        if (depth == key.size()) {
+            T *leaf = n->terminal;
+            if (leaf == nullptr || leaf->key != key) {
+                return nullptr;
+            }
+            n->terminal = nullptr;
+            Shrink(ref);
+            return leaf;
+        }
+
+        uint8_t c = key[depth];
+        uintptr_t *child = FindChild(n, c);
+        if (child == nullptr) {
+            return nullptr;
+        }
+
+        if (IsLeaf(*child)) {
+            T *leaf = ToLeaf(*child);
+            if (leaf->key != key) {
+                return nullptr;
+            }
+            RemoveChild(ref, c);
+            return leaf;
+        }
+        return Erase(*child, key, depth + 1);
+    }
+
+    // Emits entry if it fits walk conditions, returns false once walk must stop
+    static bool Visit(T *leaf, const std::string &prefix, const std::string &after,
+                      const std::function<bool(T *)> &visit) {
+        const std::string &key = leaf->key;
+        if (key < prefix || (!after.empty() && key <= after)) {
+            return true;
+        }
+        if (key.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        return visit(leaf);
+    }
+
+    // In order walk of the subtree. While tight is true path to the subtree equals to the
+    // bound, so subtrees on the left of the bound are skipped
+    bool Walk(uintptr_t ref, std::size_t depth, bool tight, const std::string &bound, const std::string &prefix,
+              const std::string &after, const std::function<bool(T *)> &visit) {
+        if (ref == 0) {
+            return true;
+        }
+        if (IsLeaf(ref)) {
+            return Visit(ToLeaf(ref), prefix, after, visit);
+        }
+
+        node *n = ToNode(ref);
+        if (tight && n->prefix_len > 0) {
+            const std::string &full = Minimum(ref)->key;
+            std::size_t len = std::min<std::size_t>(n->prefix_len, bound.size() - std::min(depth, bound.size()));
+            int cmp = full.compare(depth, len, bound, depth, len);
+            if (cmp < 0) {
+                return true;
+            }
+            tight = (cmp == 0 && len == n->prefix_len);
+        }
+        depth += n->prefix_len;
+
+        if (tight && depth >= bound.size()) {
+            tight = false;
+        }
+        if (!tight && n->terminal != nullptr && !Visit(n->terminal, prefix, after, visit)) {
+            return false;
+        }
+
+        uint8_t from = tight ? static_cast<uint8_t>(bound[depth]) : 0;
+        switch (n->type) {
+        case kNode4:
+        case kNode16: {
+            uint8_t *keys = (n->type == kNode4) ? static_cast<node4 *>(n)->keys : static_cast<node16 *>(n)->keys;
+            uintptr_t *children =
+                (n->type == kNode4) ? static_cast<node4 *>(n)->children : static_cast<node16 *>(n)->children;
+            for (int i = 0; i < n->count; i++) {
+                if (keys[i] >= from &&
+                    !Walk(children[i], depth + 1, tight && keys[i] == from, bound, prefix, after, visit)) {
+                    return false;
+                }
+            }
+            break;
+        }
+        case kNode48: {
+            node48 *p = static_cast<node48 *>(n);
+            for (int i = from; i < 256; i++) {
+                if (p->index[i] != 0 &&
+                    !Walk(p->children[p->index[i] - 1], depth + 1, tight && i == from, bound, prefix, after, visit)) {
+                    return false;
+                }
+            }
+            break;
+        }
+        case kNode256: {
+            node256 *p = static_cast<node256 *>(n);
+            for (int i = from; i < 256; i++) {
+                if (p->children[i] != 0 &&
+                    !Walk(p->children[i], depth + 1, tight && i == from, bound, prefix, after, visit)) {
+                    return false;
+                }
+            }
+            break;
+        }
+        }
+        return true;
+    }
+
+    void Destroy(uintptr_t ref) {
+        if (ref == 0 || IsLeaf(ref)) {
+            return;
+        }
+
+        node *n = ToNode(ref);
+        switch (n->type) {
+        case kNode4:
+        case kNode16: {
+            uintptr_t *children =
+                (n->type == kNode4) ? static_cast<node4 *>(n)->children : static_cast<node16 *>(n)->children;
+            for (int i = 0; i < n->count; i++) {
+                Destroy(children[i]);
+            }
+            break;
+        }
+        case kNode48: {
+            node48 *p = static_cast<node48 *>(n);
+            for (int i = 0; i < 48; i++) {
+                Destroy(p->children[i]);
+            }
+            break;
+        }
+        case kNode256: {
+            node256 *p = static_cast<node256 *>(n);
+            for (int i = 0; i < 256; i++) {
+                Destroy(p->children[i]);
+            }
+            break;
+        }
+        }
+        FreeNode(n);
+    }
+
+    // Root of the tree
+    uintptr_t _root;
+
+    // Number of entries in the tree
+    std::size_t _size;
+
+    // Memory used by inner nodes
+    std::size_t _bytes;
+
+    // Number of inner nodes of each type
+    std::size_t _nodes[4] = {0, 0, 0, 0};
+};
+
+template <typename T> constexpr std::size_t ArtIndex<T>::kMaxPrefix;
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ART_INDEX_H
@@ -0,0 +1,133 @@
+#ifndef AFINA_STORAGE_CHUNKED_VALUE_H
+#define AFINA_STORAGE_CHUNKED_VALUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Value of the storage item
+ * Small value is kept in the single string. Value larger than the chunk is kept as the chain of
+ * chunks of fixed size, so that it never needs one contiguous allocation and append copies only the
+ * data being appended instead of the whole value.
+ *
+ * Chunks are reference counted and could be handed out to readers, see Share. Shared chunk never
+ * changes: append into it makes private copy of that single chunk first.
+ *
+ * Class isn't thread safe
+ */
+class ChunkedValue {
+public:
+    static constexpr std::size_t kChunkSize = 64 << 10;
+
+    ChunkedValue() {}
+    explicit ChunkedValue(const std::string &value) { Assign(value); }
+
+    std::size_t Size() const { return _chain ? _chain->size : _value.size(); }
+
+    void Assign(const std::string &value) {
+        _chain.reset();
+        if (value.size() <= kChunkSize) {
+            _value = value;
+            return;
+        }
+
+        _value = std::string();
+        Append(value.data(), value.size());
+    }
+
+    void Append(const char *data, std::size_t size) {
+        if (!_chain && _value.size() + size <= kChunkSize) {
+            _value.append(data, size);
+            return;
+        }
+
+        // Value outgrows single chunk, what it has now becomes the first one
+        if (!_chain) {
+            _chain.reset(new Chain());
+            _chain->size = _value.size();
+            if (!_value.empty()) {
+                _chain->chunks.emplace_back(new std::string(std::move(_value)));
+                _value = std::string();
+            }
+        }
+
+        while (size > 0) {
+            if (_chain->chunks.empty() || _chain->chunks.back()->size() == kChunkSize) {
+                _chain->chunks.emplace_back(new std::string());
+                _chain->chunks.back()->reserve(kChunkSize);
+            } else if (_chain->chunks.back().use_count() > 1) {
+                std::shared_ptr<std::string> copy(new std::string());
+                copy->reserve(kChunkSize);
+                copy->append(*_chain->chunks.back());
+                _chain->chunks.back() = std::move(copy);
+            }
+
+            std::string &last = *_chain->chunks.back();
+            std::size_t piece = std::min(size, kChunkSize - last.size());
+            last.append(data, piece);
+            _chain->size += piece;
+            data += piece;
+            size -= piece;
+        }
+    }
+
+    /**
+     * Copies value into the given output
+     */
+    void CopyTo(std::string &out) const {
+        if (!_chain) {
+            out = _value;
+            return;
+        }
+
+        out.clear();
+        out.reserve(_chain->size);
+        for (auto &chunk : _chain->chunks) {
+            out.append(*chunk);
+        }
+    }
+
+    /**
+     * Returns value as the contiguous string, large value gets copied into the given buffer
+     */
+    const std::string &View(std::string &buffer) const {
+        if (!_chain) {
+            return _value;
+        }
+        CopyTo(buffer);
+        return buffer;
+    }
+
+    /**
+     * Appends pieces of the value to the given output, chunks are shared rather than copied
+     */
+    void Share(std::vector<std::shared_ptr<const std::string>> &out) const {
+        if (!_chain) {
+            out.emplace_back(new std::string(_value));
+            return;
+        }
+        out.insert(out.end(), _chain->chunks.begin(), _chain->chunks.end());
+    }
+
+private:
+    struct Chain {
+        std::vector<std::shared_ptr<std::string>> chunks;
+        std::size_t size;
+    };
+
+    std::string _value;
+
+    // Chunks of the large value, _value is empty then
+    std::unique_ptr<Chain> _chain;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CHUNKED_VALUE_H
@@ -0,0 +1,222 @@
+#include "CompressedStorage.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "Lz.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Leading byte of the stored value
+const char kPlain = 0;
+const char kLz = 1;
+
+// Compressed value: marker, original size, compressed size, compressed data and then appended data as is
+const std::size_t kLzHeader = 1 + 2 * sizeof(uint32_t);
+
+uint64_t Nanoseconds(std::chrono::steady_clock::time_point started) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started)
+        .count();
+}
+
+} // namespace
+
+// See CompressedStorage.h
+CompressedStorage::CompressedStorage(std::shared_ptr<Afina::Storage> storage, std::size_t threshold)
+    : _storage(storage), _threshold(threshold), _compressed(0), _incompressible(0), _raw_bytes(0),
+      _stored_bytes(0), _decompressed(0), _errors(0), _compress_nsec(0), _decompress_nsec(0) {}
+
+// See CompressedStorage.h
+bool CompressedStorage::Put(const std::string &key, const std::string &value) {
+    return _storage->Put(key, Encode(value));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    return _storage->PutIfAbsent(key, Encode(value));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Set(const std::string &key, const std::string &value) {
+    return _storage->Set(key, Encode(value));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Get(const std::string &key, std::string &value) {
+    std::string stored;
+    if (!_storage->Get(key, stored)) {
+        return false;
+    }
+    return Decode(stored, value);
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) {
+    std::vector<std::shared_ptr<const std::string>> stored;
+    if (!_storage->GetChunks(key, stored)) {
+        return false;
+    }
+    return Decode(stored, chunks);
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Put(const std::string &key, uint64_t hash, const std::string &value) {
+    return _storage->Put(key, hash, Encode(value));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) {
+    return _storage->PutIfAbsent(key, hash, Encode(value));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Set(const std::string &key, uint64_t hash, const std::string &value) {
+    return _storage->Set(key, hash, Encode(value));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Get(const std::string &key, uint64_t hash, std::string &value) {
+    std::string stored;
+    if (!_storage->Get(key, hash, stored)) {
+        return false;
+    }
+    return Decode(stored, value);
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::GetChunks(const std::string &key, uint64_t hash,
+                                  std::vector<std::shared_ptr<const std::string>> &chunks) {
+    std::vector<std::shared_ptr<const std::string>> stored;
+    if (!_storage->GetChunks(key, hash, stored)) {
+        return false;
+    }
+    return Decode(stored, chunks);
+}
+
+// See CompressedStorage.h
+void CompressedStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+
+    uint64_t raw = _raw_bytes.load(), stored = _stored_bytes.load();
+    char ratio[32];
+    std::snprintf(ratio, sizeof(ratio), "%.2f", stored == 0 ? 1.0 : double(raw) / stored);
+
+    stats.emplace_back("compress_threshold", std::to_string(_threshold));
+    stats.emplace_back("compress_values", std::to_string(_compressed.load()));
+    stats.emplace_back("compress_incompressible", std::to_string(_incompressible.load()));
+    stats.emplace_back("compress_raw_bytes", std::to_string(raw));
+    stats.emplace_back("compress_stored_bytes", std::to_string(stored));
+    stats.emplace_back("compress_ratio", ratio);
+    stats.emplace_back("compress_usec", std::to_string(_compress_nsec.load() / 1000));
+    stats.emplace_back("decompress_values", std::to_string(_decompressed.load()));
+    stats.emplace_back("decompress_usec", std::to_string(_decompress_nsec.load() / 1000));
+    stats.emplace_back("decompress_errors", std::to_string(_errors.load()));
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+    std::string value;
+    return _storage->Dump([this, &visit, &value](std::size_t part, const std::string &key, const std::string &stored) {
+        if (Decode(stored, value)) {
+            visit(part, key, value);
+        }
+    });
+}
+
+// See CompressedStorage.h
+std::string CompressedStorage::Encode(const std::string &value) {
+    std::string stored;
+    if (value.size() < _threshold || value.size() > UINT32_MAX) {
+        stored.reserve(value.size() + 1);
+        stored.push_back(kPlain);
+        stored.append(value);
+        return stored;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    uint32_t size = value.size();
+    stored.resize(kLzHeader);
+    stored[0] = kLz;
+    std::memcpy(&stored[1], &size, sizeof(size));
+    Lz::Compress(value.data(), value.size(), stored);
+    uint32_t compressed = stored.size() - kLzHeader;
+    std::memcpy(&stored[1 + sizeof(size)], &compressed, sizeof(compressed));
+    _compress_nsec += Nanoseconds(started);
+
+    if (stored.size() > value.size() - value.size() / 8) {
+        stored.clear();
+        stored.push_back(kPlain);
+        stored.append(value);
+        _incompressible++;
+    } else {
+        _compressed++;
+    }
+
+    _raw_bytes += value.size();
+    _stored_bytes += stored.size();
+    return stored;
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Decode(const std::string &stored, std::string &value) {
+    if (!stored.empty() && stored[0] == kPlain) {
+        value.assign(stored, 1, std::string::npos);
+        return true;
+    }
+
+    if (stored.size() < kLzHeader || stored[0] != kLz) {
+        _errors++;
+        return false;
+    }
+
+    uint32_t size, compressed;
+    std::memcpy(&size, stored.data() + 1, sizeof(size));
+    std::memcpy(&compressed, stored.data() + 1 + sizeof(size), sizeof(compressed));
+    if (compressed > stored.size() - kLzHeader) {
+        _errors++;
+        return false;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    value.clear();
+    bool ok = Lz::Decompress(stored.data() + kLzHeader, compressed, size, value);
+    _decompress_nsec += Nanoseconds(started);
+
+    if (!ok) {
+        _errors++;
+        return false;
+    }
+    value.append(stored, kLzHeader + compressed, std::string::npos);
+    _decompressed++;
+    return true;
+}
+
+// See CompressedStorage.h
+bool CompressedStorage::Decode(const std::vector<std::shared_ptr<const std::string>> &stored,
+                               std::vector<std::shared_ptr<const std::string>> &chunks) {
+    if (!stored.empty() && !stored[0]->empty() && (*stored[0])[0] == kPlain) {
+        if (stored[0]->size() > 1) {
+            chunks.emplace_back(new std::string(*stored[0], 1));
+        }
+        chunks.insert(chunks.end(), stored.begin() + 1, stored.end());
+        return true;
+    }
+
+    std::string whole, value;
+    for (auto &chunk : stored) {
+        whole.append(*chunk);
+    }
+    if (!Decode(whole, value)) {
+        return false;
+    }
+    chunks.emplace_back(new std::string(std::move(value)));
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
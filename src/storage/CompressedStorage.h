@@ -0,0 +1,152 @@
+#ifndef AFINA_STORAGE_COMPRESSED_STORAGE_H
+#define AFINA_STORAGE_COMPRESSED_STORAGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Value compression
+ * Decorates another storage compressing values not smaller than the threshold with Lz codec, so
+ * that storage fits several times more of compressible data. Get decompresses value back, clients
+ * never see compressed data.
+ *
+ * Every value stored in the decorated storage gets one byte in front: whether the rest is the value
+ * as is or its size, compressed size and compressed data. Value is stored as is if compression saves
+ * less than 1/8 of its size. Appended data is kept uncompressed after the stored value, so Append is
+ * passed to the decorated storage as is: it stays atomic and adds chunks without recompressing.
+ *
+ * Decorated storage must not be filled bypassing decorator, Dump decompresses values, so snapshots
+ * and logs keep plain values and don't depend on the compression settings.
+ *
+ * Decorator is thread safe as long as decorated storage is
+ */
+class CompressedStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to decorate
+     * @param threshold smallest value size worth compression
+     */
+    CompressedStorage(std::shared_ptr<Afina::Storage> storage, std::size_t threshold);
+
+    // Implements Afina::Storage interface
+    void Start() override { _storage->Start(); }
+
+    // Implements Afina::Storage interface
+    void Stop() override { _storage->Stop(); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override { return _storage->Append(key, data); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override {
+        return _storage->Append(key, hash, data);
+    }
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override {
+        return _storage->Scan(prefix, after, count, keys);
+    }
+
+    // Implements Afina::Storage interface
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override {
+        return _storage->DeletePrefix(prefix, count, deleted);
+    }
+
+    // Implements Afina::Storage interface
+    bool Resize(std::size_t max_size) override { return _storage->Resize(max_size); }
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    void AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        _storage->AllocatorStats(stats);
+    }
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override { return _storage->Fork(); }
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override;
+
+    // Implements Afina::Storage interface
+    bool Snapshot() override { return _storage->Snapshot(); }
+
+private:
+    // Value in the form it is kept in the decorated storage
+    std::string Encode(const std::string &value);
+
+    // Restores value, returns false if stored data is broken
+    bool Decode(const std::string &stored, std::string &value);
+
+    // Same as Decode for the value which comes in pieces. Plain value pieces are shared, only the first one
+    // gets copied to drop the leading byte
+    bool Decode(const std::vector<std::shared_ptr<const std::string>> &stored,
+                std::vector<std::shared_ptr<const std::string>> &chunks);
+
+    std::shared_ptr<Afina::Storage> _storage;
+
+    std::size_t _threshold;
+
+    // Values compressed and values stored as is because compression didn't pay off
+    std::atomic<uint64_t> _compressed;
+    std::atomic<uint64_t> _incompressible;
+
+    // Size of the values not smaller than threshold before and after encoding
+    std::atomic<uint64_t> _raw_bytes;
+    std::atomic<uint64_t> _stored_bytes;
+
+    std::atomic<uint64_t> _decompressed;
+    std::atomic<uint64_t> _errors;
+
+    // Time spent in codec
+    std::atomic<uint64_t> _compress_nsec;
+    std::atomic<uint64_t> _decompress_nsec;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COMPRESSED_STORAGE_H
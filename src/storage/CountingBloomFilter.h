@@ -0,0 +1,115 @@
+#ifndef AFINA_STORAGE_COUNTING_BLOOM_FILTER_H
+#define AFINA_STORAGE_COUNTING_BLOOM_FILTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Counting Bloom filter
+ * Approximate set of keys which allows to remove keys. Each key maps to kHashes counters, key
+ * is definitely absent if any of its counters is zero. Counters saturate and then never get
+ * decremented, so filter never gives false negative answers.
+ *
+ * Add/Remove must be serialized by the owner, while MayContain could be called from any thread
+ * without synchronization: it may miss key being added concurrently, but it never misses keys
+ * added before the call started.
+ */
+class CountingBloomFilter {
+public:
+    CountingBloomFilter(std::size_t expected_items) {
+        std::size_t size = 64;
+        while (size < expected_items * kCountersPerItem) {
+            size <<= 1;
+        }
+
+        _mask = size - 1;
+        _counters.reset(new std::atomic<uint8_t>[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            _counters[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Adds key to the set. Variants taking hash expect KeyHash of the key computed by the caller
+     */
+    void Add(const std::string &key) { Add(_hash(key)); }
+
+    void Add(uint64_t hash) {
+        for (int i = 0; i < kHashes; i++) {
+            std::atomic<uint8_t> &counter = _counters[Position(hash, i)];
+            uint8_t value = counter.load(std::memory_order_relaxed);
+            if (value < kSaturated) {
+                counter.store(value + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    /**
+     * Removes key from the set, key must be added before
+     */
+    void Remove(const std::string &key) { Remove(_hash(key)); }
+
+    void Remove(uint64_t hash) {
+        for (int i = 0; i < kHashes; i++) {
+            std::atomic<uint8_t> &counter = _counters[Position(hash, i)];
+            uint8_t value = counter.load(std::memory_order_relaxed);
+            if (value > 0 && value < kSaturated) {
+                counter.store(value - 1, std::memory_order_release);
+            }
+        }
+    }
+
+    /**
+     * Returns false if key is definitely not in the set
+     */
+    bool MayContain(const std::string &key) const { return MayContain(_hash(key)); }
+
+    bool MayContain(uint64_t hash) const {
+        for (int i = 0; i < kHashes; i++) {
+            if (_counters[Position(hash, i)].load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Number of counters in the filter
+     */
+    std::size_t Size() const { return _mask + 1; }
+
+private:
+    // Number of counters each key maps to
+    static constexpr int kHashes = 4;
+
+    // Counters per expected key, gives about 2.5% false positives once filter is full
+    static constexpr std::size_t kCountersPerItem = 8;
+
+    // Counter value which never changes anymore
+    static constexpr uint8_t kSaturated = 255;
+
+    // Derives i-th counter position from two halves of the single hash, see Kirsch & Mitzenmacher
+    inline std::size_t Position(uint64_t hash, int i) const {
+        uint32_t h1 = static_cast<uint32_t>(hash), h2 = static_cast<uint32_t>(hash >> 32);
+        return (h1 + i * h2) & _mask;
+    }
+
+    KeyHash _hash;
+
+    std::size_t _mask;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> _counters;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COUNTING_BLOOM_FILTER_H
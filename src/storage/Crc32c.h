@@ -0,0 +1,97 @@
+#ifndef AFINA_STORAGE_CRC32C_H
+#define AFINA_STORAGE_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CRC-32C (Castagnoli)
+ * Uses crc32 instruction once build targets CPU having one (SSE 4.2 on x86, CRC extension on ARM),
+ * see -march=native in the top level CMakeLists.txt. Otherwise falls back to the table driven
+ * implementation which is several times slower.
+ *
+ * Checksum of the data split into several pieces could be computed by passing result for previous
+ * pieces as initial value: Crc32c(b, Crc32c(a)) == Crc32c(a + b)
+ */
+class Crc32c {
+public:
+    static uint32_t Compute(const void *data, std::size_t size, uint32_t crc = 0) {
+        const char *p = static_cast<const char *>(data);
+        crc = ~crc;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+        uint64_t crc64 = crc;
+        for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+        crc = static_cast<uint32_t>(crc64);
+        for (; size > 0; size--, p++) {
+            crc = _mm_crc32_u8(crc, *p);
+        }
+#elif defined(__ARM_FEATURE_CRC32)
+        for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            crc = __crc32cd(crc, word);
+        }
+        for (; size > 0; size--, p++) {
+            crc = __crc32cb(crc, *p);
+        }
+#else
+        const uint32_t *table = Table();
+        for (; size > 0; size--, p++) {
+            crc = table[(crc ^ static_cast<uint8_t>(*p)) & 0xff] ^ (crc >> 8);
+        }
+#endif
+        return ~crc;
+    }
+
+    /**
+     * Returns true if hardware implementation is used
+     */
+    static constexpr bool Hardware() {
+#if (defined(__SSE4_2__) && defined(__x86_64__)) || defined(__ARM_FEATURE_CRC32)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    // Reflected Castagnoli polynomial
+    static constexpr uint32_t kPolynomial = 0x82f63b78;
+
+    static const uint32_t *Table() {
+        struct Holder {
+            Holder() {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t crc = i;
+                    for (int bit = 0; bit < 8; bit++) {
+                        crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+                    }
+                    table[i] = crc;
+                }
+            }
+            uint32_t table[256];
+        };
+
+        static const Holder holder;
+        return holder.table;
+    }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CRC32C_H
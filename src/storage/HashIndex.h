@@ -0,0 +1,287 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Index.h"
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash table based index with incremental resize
+ * Index is a chained hash table which never rehash all entries at once. Once table needs to
+ * grow (or shrink) the new bucket array gets allocated and both tables live together for a while:
+ * each operation on the index migrates a few buckets from the old table to the new one, and the
+ * owner could migrate more from the background by calling Maintain. Lookups check both tables
+ * during migration, new entries always go into the new table.
+ *
+ * That way cost of the resize is spread between many operations and latency of each one stays flat
+ */
+template <typename T, typename Hash = KeyHash> class HashIndex : public Index<T> {
+public:
+    HashIndex(std::size_t buckets = kMinBuckets)
+        : _rehash_idx(0), _rehash_total(0), _rehash_buckets(0), _rehash_usec(0), _rehash_max_step_usec(0) {
+        std::size_t size = kMinBuckets;
+        while (size < buckets) {
+            size <<= 1;
+        }
+        _tables[0].Reset(size);
+    }
+
+    ~HashIndex() { Clear(); }
+
+    // See Index.h
+    T *Find(const std::string &key) override { return Find(key, _hash(key)); }
+
+    // See Index.h
+    T *Find(const std::string &key, uint64_t hash) override {
+        Step(kStepsPerOperation);
+
+        slot **place = Lookup(key, hash);
+        if (place == nullptr) {
+            return nullptr;
+        }
+        return (*place)->entry;
+    }
+
+    // See Index.h
+    void Insert(T *entry) override { Insert(entry, _hash(entry->key)); }
+
+    // See Index.h
+    void Insert(T *entry, uint64_t hash) override {
+        Step(kStepsPerOperation);
+        if (!Rehashing() && _tables[0].used >= _tables[0].buckets.size()) {
+            StartRehash(_tables[0].buckets.size() << 1);
+        }
+
+        table &to = Rehashing() ? _tables[1] : _tables[0];
+        slot *s = new slot;
+        s->hash = hash;
+        s->entry = entry;
+        to.Link(s);
+    }
+
+    // See Index.h
+    T *Erase(const std::string &key) override { return Erase(key, _hash(key)); }
+
+    // See Index.h
+    T *Erase(const std::string &key, uint64_t hash) override {
+        Step(kStepsPerOperation);
+
+        table *from = nullptr;
+        slot **place = Lookup(key, hash, &from);
+        if (place == nullptr) {
+            return nullptr;
+        }
+
+        slot *s = *place;
+        *place = s->next;
+        T *result = s->entry;
+        delete s;
+        from->used--;
+
+        // Shrink table if it becomes too sparse, keeps memory proportional to the number of entries
+        std::size_t buckets = _tables[0].buckets.size();
+        if (!Rehashing() && buckets > kMinBuckets && _tables[0].used * kShrinkRatio < buckets) {
+            std::size_t size = kMinBuckets;
+            while (size < _tables[0].used * 2) {
+                size <<= 1;
+            }
+            StartRehash(size);
+        }
+        return result;
+    }
+
+    // See Index.h
+    void Clear() override {
+        _tables[0].Destroy();
+        _tables[1].Destroy();
+        _tables[0].Reset(kMinBuckets);
+        _rehash_idx = 0;
+    }
+
+    // See Index.h
+    std::size_t Size() const override { return _tables[0].used + _tables[1].used; }
+
+    // See Index.h
+    bool MaintenancePending() const override { return Rehashing(); }
+
+    // See Index.h
+    bool Maintain(std::size_t steps) override {
+        Step(steps);
+        return Rehashing();
+    }
+
+    // See Index.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) const override {
+        stats.emplace_back("index_type", "hash");
+        stats.emplace_back("index_buckets", std::to_string(_tables[0].buckets.size()));
+        stats.emplace_back("index_rehashing", Rehashing() ? "1" : "0");
+        stats.emplace_back("index_rehash_target_buckets", std::to_string(_tables[1].buckets.size()));
+        stats.emplace_back("index_rehash_total", std::to_string(_rehash_total));
+        stats.emplace_back("index_rehash_buckets_moved", std::to_string(_rehash_buckets));
+        stats.emplace_back("index_rehash_usec", std::to_string(_rehash_usec));
+        stats.emplace_back("index_rehash_max_step_usec", std::to_string(_rehash_max_step_usec));
+    }
+
+    /**
+     * True if index is in the middle of resize, i.e there are two tables
+     */
+    inline bool Rehashing() const { return !_tables[1].buckets.empty(); }
+
+private:
+    // Minimal number of buckets in the table, must be power of 2
+    static constexpr std::size_t kMinBuckets = 16;
+
+    // How many buckets migrate on each index operation
+    static constexpr std::size_t kStepsPerOperation = 2;
+
+    // How many empty buckets could be visited per each migrated one, bounds time of single step
+    static constexpr std::size_t kEmptyVisits = 10;
+
+    // Table shrinks once number of entries is that times less then number of buckets
+    static constexpr std::size_t kShrinkRatio = 8;
+
+    // Chain element, hash is cached so that migration and lookups don't need to compute it again
+    struct slot {
+        std::size_t hash;
+        T *entry;
+        slot *next;
+    };
+
+    struct table {
+        std::vector<slot *> buckets;
+        std::size_t used = 0;
+
+        void Reset(std::size_t size) {
+            buckets.assign(size, nullptr);
+            used = 0;
+        }
+
+        inline slot *&Bucket(std::size_t hash) { return buckets[hash & (buckets.size() - 1)]; }
+
+        void Link(slot *s) {
+            slot *&head = Bucket(s->hash);
+            s->next = head;
+            head = s;
+            used++;
+        }
+
+        void Destroy() {
+            for (slot *head : buckets) {
+                while (head != nullptr) {
+                    slot *next = head->next;
+                    delete head;
+                    head = next;
+                }
+            }
+            buckets.clear();
+            buckets.shrink_to_fit();
+            used = 0;
+        }
+    };
+
+    // Returns address of the pointer to the slot with the given key, or nullptr if there is no such.
+    // If found is given it gets the table slot lives in
+    slot **Lookup(const std::string &key, std::size_t hash, table **found = nullptr) {
+        for (int i = 0; i < 2; i++) {
+            table &t = _tables[i];
+            if (t.buckets.empty()) {
+                break;
+            }
+
+            for (slot **place = &t.Bucket(hash); *place != nullptr; place = &(*place)->next) {
+                if ((*place)->hash == hash && KeyHash::Equal((*place)->entry->key, key)) {
+                    if (found != nullptr) {
+                        *found = &t;
+                    }
+                    return place;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    void StartRehash(std::size_t size) {
+        _tables[1].Reset(size);
+        _rehash_idx = 0;
+    }
+
+    // Migrates up to given number of non-empty buckets from the old table into the new one
+    void Step(std::size_t steps) {
+        if (!Rehashing()) {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<slot *> &from = _tables[0].buckets;
+        std::size_t empty_visits = steps * kEmptyVisits;
+        while (steps > 0 && _rehash_idx < from.size()) {
+            slot *head = from[_rehash_idx];
+            if (head == nullptr) {
+                _rehash_idx++;
+                if (--empty_visits == 0) {
+                    break;
+                }
+                continue;
+            }
+
+            while (head != nullptr) {
+                slot *next = head->next;
+                _tables[0].used--;
+                _tables[1].Link(head);
+                head = next;
+            }
+
+            from[_rehash_idx++] = nullptr;
+            _rehash_buckets++;
+            steps--;
+        }
+
+        // Migration is done, new table becomes the main one
+        if (_rehash_idx >= from.size()) {
+            _tables[0].buckets.swap(_tables[1].buckets);
+            _tables[0].used = _tables[1].used;
+            _tables[1].buckets.clear();
+            _tables[1].buckets.shrink_to_fit();
+            _tables[1].used = 0;
+            _rehash_idx = 0;
+            _rehash_total++;
+        }
+
+        auto spent = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        _rehash_usec += spent.count();
+        _rehash_max_step_usec = std::max<uint64_t>(_rehash_max_step_usec, spent.count());
+    }
+
+    Hash _hash;
+
+    // Main table and table entries get migrated to during resize. Second one has no buckets
+    // unless resize is in progress
+    table _tables[2];
+
+    // Index of the next bucket in _tables[0] to be migrated
+    std::size_t _rehash_idx;
+
+    // Number of resizes completed
+    uint64_t _rehash_total;
+
+    // Number of non-empty buckets migrated between tables
+    uint64_t _rehash_buckets;
+
+    // Total time spent on migration and the longest single step
+    uint64_t _rehash_usec;
+    uint64_t _rehash_max_step_usec;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,108 @@
+#ifndef AFINA_STORAGE_INDEX_H
+#define AFINA_STORAGE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Index implementations storages could be configured with
+ * - kMap: balanced tree, keeps keys ordered
+ * - kHash: hash table with incremental resize
+ * - kArt: adaptive radix tree, keeps keys ordered and compact for keys with long common prefixes
+ */
+enum class IndexType { kMap, kHash, kArt };
+
+/**
+ * # Storage index
+ * Provides fast random access to the storage entries by key. Index doesn't own
+ * entries, it keeps pointers only, so storage must remove entry from the index
+ * before destroy it.
+ *
+ * Entry type T must have public std::string field "key" which must not be changed
+ * while entry is in the index.
+ */
+template <typename T> class Index {
+public:
+    Index() {}
+    virtual ~Index() {}
+
+    /**
+     * Returns entry associated with the given key or nullptr if there is no such entry
+     */
+    virtual T *Find(const std::string &key) = 0;
+
+    /**
+     * Adds given entry into index. Caller must guarantee that there is no other
+     * entry with the same key in the index yet
+     */
+    virtual void Insert(T *entry) = 0;
+
+    /**
+     * Removes association for the given key. Method returns removed entry or nullptr
+     * if key wasn't found
+     */
+    virtual T *Erase(const std::string &key) = 0;
+
+    /**
+     * Same as Find, Insert and Erase above for the key which KeyHash is known. Indexes which don't
+     * hash keys just drop it
+     */
+    virtual T *Find(const std::string &key, uint64_t hash) { return Find(key); }
+
+    virtual void Insert(T *entry, uint64_t hash) { Insert(entry); }
+
+    virtual T *Erase(const std::string &key, uint64_t hash) { return Erase(key); }
+
+    /**
+     * Removes all entries from the index
+     */
+    virtual void Clear() = 0;
+
+    /**
+     * Number of entries in the index
+     */
+    virtual std::size_t Size() const = 0;
+
+    /**
+     * Calls visit for entries with keys starting by the given prefix, in ascending order of keys.
+     * Walk starts from the first key greater than after, or from the first key with the prefix if
+     * after is empty, and stops once visit returns false. Visit must not modify the index.
+     *
+     * Method returns false if index doesn't keep keys ordered, so walk isn't possible
+     */
+    virtual bool Walk(const std::string &prefix, const std::string &after, const std::function<bool(T *)> &visit) {
+        return false;
+    }
+
+    /**
+     * Returns true if index has deferred work to be done by Maintain
+     */
+    virtual bool MaintenancePending() const { return false; }
+
+    /**
+     * Performs deferred index work, for example incremental rehash, spending not
+     * more than given number of steps. Returns true if there is still work to do
+     */
+    virtual bool Maintain(std::size_t steps) { return false; }
+
+    /**
+     * Appends index counters to the given output, see Afina::Storage::Stats
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) const {}
+
+private:
+    Index(const Index &);            // = delete;
+    Index &operator=(const Index &); // = delete;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_INDEX_H
@@ -0,0 +1,128 @@
+#include "KeyHash.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define AFINA_KEY_HASH_X86
+#endif
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+bool EqualMemcmp(const char *a, const char *b, std::size_t size) { return std::memcmp(a, b, size) == 0; }
+
+#ifdef AFINA_KEY_HASH_X86
+
+// Keys shorter than a vector: two overlapping words of the largest size that fits
+inline bool EqualShort(const char *a, const char *b, std::size_t size) {
+    if (size >= 8) {
+        uint64_t a0, a1, b0, b1;
+        std::memcpy(&a0, a, 8);
+        std::memcpy(&b0, b, 8);
+        std::memcpy(&a1, a + size - 8, 8);
+        std::memcpy(&b1, b + size - 8, 8);
+        return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+    }
+    if (size >= 4) {
+        uint32_t a0, a1, b0, b1;
+        std::memcpy(&a0, a, 4);
+        std::memcpy(&b0, b, 4);
+        std::memcpy(&a1, a + size - 4, 4);
+        std::memcpy(&b1, b + size - 4, 4);
+        return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+    }
+    for (std::size_t i = 0; i < size; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+__attribute__((target("sse4.2"))) inline __m128i Diff16(const char *a, const char *b) {
+    return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+}
+
+__attribute__((target("sse4.2"))) bool EqualSse(const char *a, const char *b, std::size_t size) {
+    if (size < 16) {
+        return EqualShort(a, b, size);
+    }
+
+    // Last vector overlaps the previous one instead of the scalar tail
+    std::size_t last = size - 16;
+    __m128i diff = Diff16(a + last, b + last);
+    for (std::size_t i = 0; i < last; i += 16) {
+        diff = _mm_or_si128(diff, Diff16(a + i, b + i));
+    }
+    return _mm_testz_si128(diff, diff);
+}
+
+__attribute__((target("avx2"))) inline __m256i Diff32(const char *a, const char *b) {
+    return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a)),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)));
+}
+
+__attribute__((target("avx2"))) bool EqualAvx2(const char *a, const char *b, std::size_t size) {
+    if (size < 32) {
+        return EqualSse(a, b, size);
+    }
+
+    // Keys up to 64 bytes take two overlapping vectors and a single branch, longer ones bail out on
+    // the first difference every 128 bytes
+    std::size_t last = size - 32;
+    __m256i diff = _mm256_or_si256(Diff32(a, b), Diff32(a + last, b + last));
+    for (std::size_t i = 32; i < last; i += 32) {
+        if ((i & 127) == 0 && !_mm256_testz_si256(diff, diff)) {
+            return false;
+        }
+        diff = _mm256_or_si256(diff, Diff32(a + i, b + i));
+    }
+    return _mm256_testz_si256(diff, diff);
+}
+
+#endif // AFINA_KEY_HASH_X86
+
+} // namespace
+
+// Starts with the resolver, so that there is no dependency on the order of static initialization
+std::atomic<KeyHash::EqualFunction> KeyHash::_equal(&KeyHash::Resolve);
+
+// See KeyHash.h
+KeyHash::EqualFunction KeyHash::Select() {
+#ifdef AFINA_KEY_HASH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &EqualAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return &EqualSse;
+    }
+#endif
+    return &EqualMemcmp;
+}
+
+// See KeyHash.h
+bool KeyHash::Resolve(const char *a, const char *b, std::size_t size) {
+    EqualFunction equal = Select();
+    _equal.store(equal, std::memory_order_relaxed);
+    return equal(a, b, size);
+}
+
+// See KeyHash.h
+const char *KeyHash::Implementation() {
+    EqualFunction equal = Select();
+#ifdef AFINA_KEY_HASH_X86
+    if (equal == &EqualAvx2) {
+        return "avx2";
+    }
+    if (equal == &EqualSse) {
+        return "sse4.2";
+    }
+#endif
+    return "memcmp";
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,57 @@
+#ifndef AFINA_STORAGE_KEY_HASH_H
+#define AFINA_STORAGE_KEY_HASH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <afina/KeyHash.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hashing and comparison of keys
+ * Hash comes from Afina::KeyHash shared with the protocol layer, storage adds fast comparison of
+ * keys to it.
+ *
+ * Keys are compared with the widest vector instructions CPU has (AVX2 or SSE 4.2), picked on the
+ * first call at runtime, so that the binary built for one CPU works on the other. Falls back to
+ * memcmp elsewhere.
+ *
+ * Class is usable as the hasher of std containers and HashIndex
+ */
+class KeyHash : public Afina::KeyHash {
+public:
+    /**
+     * Returns true if both keys have the same bytes
+     */
+    static bool Equal(const std::string &a, const std::string &b) {
+        return a.size() == b.size() && Equal(a.data(), b.data(), a.size());
+    }
+
+    static bool Equal(const char *a, const char *b, std::size_t size) {
+        return _equal.load(std::memory_order_relaxed)(a, b, size);
+    }
+
+    /**
+     * Name of the comparison routine used on this CPU: avx2, sse4.2 or memcmp
+     */
+    static const char *Implementation();
+
+private:
+    typedef bool (*EqualFunction)(const char *, const char *, std::size_t);
+
+    // Picks implementation for the CPU, stores it into _equal and runs it
+    static bool Resolve(const char *a, const char *b, std::size_t size);
+
+    static EqualFunction Select();
+
+    static std::atomic<EqualFunction> _equal;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_KEY_HASH_H
@@ -0,0 +1,597 @@
+#include "LogStorage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Crc32c.h"
+#include "SnapshotStorage.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Checksum and size of the record rest
+const std::size_t kRecordHeader = 2 * sizeof(uint32_t);
+
+// Operation code, key size and value size
+const std::size_t kRecordPrefix = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+
+// How often writer checks compaction child while there is nothing to write
+const std::chrono::milliseconds kPollInterval(100);
+
+// Opens directory and syncs it, so that created and renamed files survive crash
+void SyncDirectory(const std::string &dir) {
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+} // namespace
+
+// See LogStorage.h
+LogStorage::LogStorage(std::shared_ptr<Afina::Storage> storage, const std::string &dir, const std::string &prefix,
+                       std::size_t window, std::size_t compact_bytes)
+    : _storage(std::move(storage)), _dir(dir), _prefix(prefix), _window(window), _compact_bytes(compact_bytes),
+      _running(false), _failed(false), _appended(0), _committed(0), _fd(-1), _segment(0), _segment_bytes(0),
+      _child(0), _child_segment(0), _records(0), _bytes(0), _commits(0), _compactions(0), _compactions_failed(0),
+      _replayed(0), _replay_torn(0) {}
+
+// See LogStorage.h
+LogStorage::~LogStorage() { Stop(); }
+
+// See LogStorage.h
+void LogStorage::Start() {
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    if (_running) {
+        return;
+    }
+
+    if (mkdir(_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create log directory " + _dir + ": " + std::strerror(errno));
+    }
+
+    // Never append to existing segments, those may end with the torn record
+    std::vector<uint64_t> segments = List("log"), snapshots = List("snapshot");
+    _segment = 1;
+    if (!segments.empty()) {
+        _segment = std::max(_segment, segments.back() + 1);
+    }
+    if (!snapshots.empty()) {
+        _segment = std::max(_segment, snapshots.back());
+    }
+
+    _fd = open(Path("log", _segment).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        throw std::runtime_error("Failed to create log segment: " + std::string(std::strerror(errno)));
+    }
+    SyncDirectory(_dir);
+
+    _storage->Start();
+    _segment_bytes = 0;
+    _failed = false;
+    _running = true;
+    _writer = std::thread(&LogStorage::OnWrite, this);
+}
+
+// See LogStorage.h
+void LogStorage::Stop() {
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    if (!_running) {
+        return;
+    }
+
+    // Writer flushes everything queued before it exits
+    _running = false;
+    _queue_changed.notify_all();
+    lock.unlock();
+    _writer.join();
+    lock.lock();
+
+    Reap(true);
+    close(_fd);
+    _fd = -1;
+    _storage->Stop();
+}
+
+// See LogStorage.h
+bool LogStorage::Put(const std::string &key, const std::string &value) { return Put(key, _hash(key), value); }
+
+// See LogStorage.h
+bool LogStorage::Put(const std::string &key, uint64_t hash, const std::string &value) {
+    if (!Logged(key)) {
+        return _storage->Put(key, hash, value);
+    }
+
+    uint64_t ticket;
+    {
+        std::unique_lock<std::mutex> stripe(Stripe(hash));
+        if (!_storage->Put(key, hash, value)) {
+            return false;
+        }
+        ticket = Append(Operation::kPut, key, value);
+    }
+    return Commit(ticket);
+}
+
+// See LogStorage.h
+bool LogStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsent(key, _hash(key), value);
+}
+
+// See LogStorage.h
+bool LogStorage::PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) {
+    if (!Logged(key)) {
+        return _storage->PutIfAbsent(key, hash, value);
+    }
+
+    uint64_t ticket;
+    {
+        std::unique_lock<std::mutex> stripe(Stripe(hash));
+        if (!_storage->PutIfAbsent(key, hash, value)) {
+            return false;
+        }
+        ticket = Append(Operation::kPut, key, value);
+    }
+    return Commit(ticket);
+}
+
+// See LogStorage.h
+bool LogStorage::Set(const std::string &key, const std::string &value) { return Set(key, _hash(key), value); }
+
+// See LogStorage.h
+bool LogStorage::Set(const std::string &key, uint64_t hash, const std::string &value) {
+    if (!Logged(key)) {
+        return _storage->Set(key, hash, value);
+    }
+
+    uint64_t ticket;
+    {
+        std::unique_lock<std::mutex> stripe(Stripe(hash));
+        if (!_storage->Set(key, hash, value)) {
+            return false;
+        }
+        ticket = Append(Operation::kPut, key, value);
+    }
+    return Commit(ticket);
+}
+
+// See LogStorage.h
+bool LogStorage::Append(const std::string &key, const std::string &data) { return Append(key, _hash(key), data); }
+
+// See LogStorage.h
+bool LogStorage::Append(const std::string &key, uint64_t hash, const std::string &data) {
+    if (!Logged(key)) {
+        return _storage->Append(key, hash, data);
+    }
+
+    // Only appended data gets logged, not the whole value
+    uint64_t ticket;
+    {
+        std::unique_lock<std::mutex> stripe(Stripe(hash));
+        if (!_storage->Append(key, hash, data)) {
+            return false;
+        }
+        ticket = Append(Operation::kAppend, key, data);
+    }
+    return Commit(ticket);
+}
+
+// See LogStorage.h
+bool LogStorage::Delete(const std::string &key) {
+    if (!Logged(key)) {
+        return _storage->Delete(key);
+    }
+
+    uint64_t ticket;
+    {
+        std::unique_lock<std::mutex> stripe(Stripe(_hash(key)));
+        if (!_storage->Delete(key)) {
+            return false;
+        }
+        ticket = Append(Operation::kDelete, key, "");
+    }
+    return Commit(ticket);
+}
+
+// See LogStorage.h
+bool LogStorage::DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) {
+    // Prefix covers some of logged keys if one of prefixes starts with another
+    if (!Logged(prefix) && _prefix.compare(0, prefix.size(), prefix) != 0) {
+        return _storage->DeletePrefix(prefix, count, deleted);
+    }
+
+    // Keys to be removed are unknown in advance, so all of them get locked. Removed keys are found by the scan
+    // and logged one by one: replaying "first count keys" on the rebuilt storage could remove other keys since
+    // it has no unlogged ones and might evict differently
+    uint64_t ticket = 0;
+    bool logged = false;
+    {
+        std::vector<std::unique_lock<std::mutex>> stripes;
+        for (auto &stripe : _stripes) {
+            stripes.emplace_back(stripe);
+        }
+
+        deleted = 0;
+        std::string after;
+        while (deleted < count) {
+            std::vector<std::string> keys;
+            std::size_t portion = count - deleted;
+            if (!_storage->Scan(prefix, after, portion, keys)) {
+                if (after.empty()) {
+                    return false;
+                }
+                break;
+            }
+
+            for (auto &key : keys) {
+                if (!_storage->Delete(key)) {
+                    continue;
+                }
+                deleted++;
+                if (Logged(key)) {
+                    ticket = Append(Operation::kDelete, key, "");
+                    logged = true;
+                }
+            }
+
+            if (keys.size() < portion) {
+                break;
+            }
+            after = keys.back();
+        }
+    }
+    return !logged || Commit(ticket);
+}
+
+// See LogStorage.h
+void LogStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    stats.emplace_back("log_records", std::to_string(_records));
+    stats.emplace_back("log_bytes", std::to_string(_bytes));
+    stats.emplace_back("log_commits", std::to_string(_commits));
+    stats.emplace_back("log_failed", _failed ? "1" : "0");
+    stats.emplace_back("log_segment", std::to_string(_segment));
+    stats.emplace_back("log_segment_bytes", std::to_string(_segment_bytes));
+    stats.emplace_back("log_compactions", std::to_string(_compactions));
+    stats.emplace_back("log_compactions_failed", std::to_string(_compactions_failed));
+    stats.emplace_back("log_replayed", std::to_string(_replayed));
+    stats.emplace_back("log_replay_torn", std::to_string(_replay_torn));
+    stats.emplace_back("log_crc32c_hardware", Crc32c::Hardware() ? "1" : "0");
+}
+
+// See LogStorage.h
+std::size_t LogStorage::Replay(std::size_t threads) {
+    std::vector<uint64_t> snapshots = List("snapshot"), segments = List("log");
+
+    uint64_t first = 0;
+    if (!snapshots.empty()) {
+        first = snapshots.back();
+        SnapshotStorage::Read(*_storage, Path("snapshot", first), threads);
+    }
+
+    std::size_t replayed = 0;
+    for (uint64_t segment : segments) {
+        if (segment >= first) {
+            replayed += ReplaySegment(Path("log", segment));
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    _replayed += replayed;
+    return replayed;
+}
+
+// See LogStorage.h
+std::mutex &LogStorage::Stripe(uint64_t hash) { return _stripes[hash % kStripes]; }
+
+// See LogStorage.h
+uint64_t LogStorage::Append(Operation operation, const std::string &key, const std::string &value) {
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    if (!_running) {
+        // Nothing is logged while storage isn't running
+        return _committed;
+    }
+
+    uint32_t size = kRecordPrefix + key.size() + value.size();
+    std::size_t offset = _pending.size();
+    _pending.resize(offset + kRecordHeader + size);
+
+    char *record = &_pending[offset];
+    char *p = record + kRecordHeader;
+    *p++ = static_cast<char>(operation);
+
+    uint32_t sizes[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+    std::memcpy(p, sizes, sizeof(sizes));
+    p += sizeof(sizes);
+    std::memcpy(p, key.data(), key.size());
+    std::memcpy(p + key.size(), value.data(), value.size());
+
+    uint32_t crc = Crc32c::Compute(&size, sizeof(size));
+    crc = Crc32c::Compute(record + kRecordHeader, size, crc);
+    std::memcpy(record, &crc, sizeof(crc));
+    std::memcpy(record + sizeof(crc), &size, sizeof(size));
+
+    _records++;
+    _queue_changed.notify_one();
+    return ++_appended;
+}
+
+// See LogStorage.h
+bool LogStorage::Commit(uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    _committed_changed.wait(lock, [this, ticket] { return _committed >= ticket || _failed; });
+    return !_failed;
+}
+
+// See LogStorage.h
+void LogStorage::OnWrite() {
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    while (_running || !_pending.empty()) {
+        Reap(false);
+        if (_pending.empty()) {
+            _queue_changed.wait_for(lock, kPollInterval);
+            continue;
+        }
+
+        // Let records of other workers join the group
+        if (_window > 0 && _running) {
+            _queue_changed.wait_for(lock, std::chrono::microseconds(_window), [this] { return !_running; });
+        }
+
+        std::vector<char> batch;
+        batch.swap(_pending);
+        uint64_t ticket = _appended;
+
+        lock.unlock();
+        bool written = Flush(batch);
+        lock.lock();
+
+        _failed = _failed || !written;
+        _committed = ticket;
+        _commits++;
+        _bytes += batch.size();
+        _segment_bytes += batch.size();
+        _committed_changed.notify_all();
+
+        if (written && _running && _child == 0 && _segment_bytes >= _compact_bytes) {
+            lock.unlock();
+            Compact();
+            lock.lock();
+        }
+    }
+}
+
+// See LogStorage.h
+bool LogStorage::Flush(const std::vector<char> &batch) {
+    std::size_t done = 0;
+    while (done < batch.size()) {
+        ssize_t n = write(_fd, batch.data() + done, batch.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return fdatasync(_fd) == 0;
+}
+
+// See LogStorage.h
+void LogStorage::Compact() {
+    // Clients are blocked while segments get switched, so the new one starts exactly at the image
+    // child gets
+    std::vector<std::unique_lock<std::mutex>> stripes;
+    for (auto &stripe : _stripes) {
+        stripes.emplace_back(stripe);
+    }
+
+    std::unique_lock<std::mutex> lock(_queue_lock);
+    std::vector<char> batch;
+    batch.swap(_pending);
+    uint64_t ticket = _appended;
+    uint64_t next = _segment + 1;
+
+    lock.unlock();
+    bool written = batch.empty() || Flush(batch);
+    int fd = open(Path("log", next).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    pid_t pid = -1;
+    if (written && fd >= 0) {
+        SyncDirectory(_dir);
+        pid = _storage->Fork();
+        if (pid == 0) {
+            // Child has only this thread, everything else is frozen at the state of fork
+            bool ok = SnapshotStorage::Write(*_storage, Path("snapshot", next), _prefix);
+            if (ok) {
+                SyncDirectory(_dir);
+            }
+            _exit(ok ? 0 : 1);
+        }
+    }
+    lock.lock();
+
+    _failed = _failed || !written;
+    _committed = ticket;
+    _commits += batch.empty() ? 0 : 1;
+    _bytes += batch.size();
+    _segment_bytes += batch.size();
+    _committed_changed.notify_all();
+
+    if (pid < 0) {
+        // Keep writing to the current segment, compaction is retried after the next commit
+        if (fd >= 0) {
+            close(fd);
+            unlink(Path("log", next).c_str());
+        }
+        _compactions_failed++;
+        return;
+    }
+
+    close(_fd);
+    _fd = fd;
+    _segment = next;
+    _segment_bytes = 0;
+    _child = pid;
+    _child_segment = next;
+}
+
+// See LogStorage.h
+void LogStorage::Reap(bool wait) {
+    if (_child == 0) {
+        return;
+    }
+
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(_child, &status, wait ? 0 : WNOHANG);
+    } while (result < 0 && errno == EINTR);
+
+    if (result == 0) {
+        return;
+    }
+
+    _child = 0;
+    if (result < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        unlink(Path("snapshot", _child_segment).c_str());
+        _compactions_failed++;
+        return;
+    }
+
+    // New snapshot covers everything written before its segment
+    for (uint64_t seq : List("log")) {
+        if (seq < _child_segment) {
+            unlink(Path("log", seq).c_str());
+        }
+    }
+    for (uint64_t seq : List("snapshot")) {
+        if (seq < _child_segment) {
+            unlink(Path("snapshot", seq).c_str());
+        }
+    }
+    _compactions++;
+}
+
+// See LogStorage.h
+std::vector<uint64_t> LogStorage::List(const std::string &name) const {
+    std::vector<uint64_t> result;
+    DIR *dir = opendir(_dir.c_str());
+    if (dir == nullptr) {
+        return result;
+    }
+
+    std::string prefix = name + ".";
+    while (struct dirent *entry = readdir(dir)) {
+        const char *file = entry->d_name;
+        if (std::strncmp(file, prefix.c_str(), prefix.size()) != 0) {
+            continue;
+        }
+
+        // Skip temporary files and anything else not ending with the number
+        char *end = nullptr;
+        uint64_t seq = std::strtoull(file + prefix.size(), &end, 10);
+        if (end != file + prefix.size() && *end == '\0') {
+            result.push_back(seq);
+        }
+    }
+    closedir(dir);
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// See LogStorage.h
+std::string LogStorage::Path(const std::string &name, uint64_t seq) const {
+    return _dir + "/" + name + "." + std::to_string(seq);
+}
+
+// See LogStorage.h
+std::size_t LogStorage::ReplaySegment(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open log segment " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    std::size_t size = st.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map log segment " + path + ": " + std::strerror(error));
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    const char *p = static_cast<const char *>(data), *end = p + size;
+    std::size_t replayed = 0;
+    std::string key, value;
+    while (p < end) {
+        uint32_t crc, length, sizes[2];
+        if (static_cast<std::size_t>(end - p) < kRecordHeader + kRecordPrefix) {
+            break;
+        }
+        std::memcpy(&crc, p, sizeof(crc));
+        std::memcpy(&length, p + sizeof(crc), sizeof(length));
+        if (length < kRecordPrefix || length > static_cast<std::size_t>(end - p) - kRecordHeader) {
+            break;
+        }
+
+        const char *body = p + kRecordHeader;
+        if (Crc32c::Compute(body, length, Crc32c::Compute(&length, sizeof(length))) != crc) {
+            break;
+        }
+
+        std::memcpy(sizes, body + 1, sizeof(sizes));
+        if (uint64_t(sizes[0]) + sizes[1] + kRecordPrefix != length) {
+            break;
+        }
+        key.assign(body + kRecordPrefix, sizes[0]);
+        value.assign(body + kRecordPrefix + sizes[0], sizes[1]);
+
+        switch (static_cast<Operation>(body[0])) {
+        case Operation::kPut:
+            _storage->Put(key, value);
+            break;
+        case Operation::kDelete:
+            _storage->Delete(key);
+            break;
+        case Operation::kAppend:
+            _storage->Append(key, value);
+            break;
+        }
+
+        p = body + length;
+        replayed++;
+    }
+
+    if (p < end) {
+        std::unique_lock<std::mutex> lock(_queue_lock);
+        _replay_torn++;
+    }
+
+    munmap(data, size);
+    return replayed;
+}
+
+} // namespace Backend
+} // namespace Afina
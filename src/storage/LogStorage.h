@@ -0,0 +1,243 @@
+#ifndef AFINA_STORAGE_LOG_STORAGE_H
+#define AFINA_STORAGE_LOG_STORAGE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Mutation log
+ * Decorates another storage making changes of keys with the given prefix durable. Every successful
+ * mutation of such a key is appended to the log and operation returns only once record is on disk.
+ *
+ * Records are written by the dedicated thread: it takes everything accumulated by all workers during
+ * the group commit window, writes it at once and calls fdatasync, so that the cost of fsync is
+ * shared by all operations of the group. Mutations of the same key are serialized by striped locks,
+ * so log order matches the order changes are applied to the storage.
+ *
+ * Log lives in the directory as a sequence of segments "log.<n>". Once current segment grows above
+ * the limit it gets compacted: writer forks storage image and switches to the next segment, the
+ * child writes "snapshot.<n+1>" in SnapshotStorage format, after that older segments and snapshots
+ * are removed. Replay loads the latest snapshot and then applies segments following it.
+ *
+ * Each record is CRC32C checksum and size of the rest as 32-bit numbers, then operation code, key
+ * size and value size followed by key and value bytes. Replay stops reading segment at the first
+ * broken record, that is the tail of the write interrupted by crash.
+ */
+class LogStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to decorate
+     * @param dir directory to keep log in, created if doesn't exist
+     * @param prefix only keys starting with it are logged
+     * @param window group commit window in microseconds
+     * @param compact_bytes segment size triggering compaction
+     */
+    LogStorage(std::shared_ptr<Afina::Storage> storage, const std::string &dir, const std::string &prefix = "",
+               std::size_t window = 1000, std::size_t compact_bytes = 64 << 20);
+    ~LogStorage();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        return _storage->GetChunks(key, chunks);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override {
+        return _storage->Get(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        return _storage->GetChunks(key, hash, chunks);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override {
+        return _storage->Scan(prefix, after, count, keys);
+    }
+
+    // Implements Afina::Storage interface
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override;
+
+    // Implements Afina::Storage interface
+    bool Resize(std::size_t max_size) override { return _storage->Resize(max_size); }
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    void AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        _storage->AllocatorStats(stats);
+    }
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override { return _storage->Fork(); }
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override {
+        return _storage->Dump(visit);
+    }
+
+    // Implements Afina::Storage interface
+    bool Snapshot() override { return _storage->Snapshot(); }
+
+    /**
+     * Loads the latest log snapshot and applies all log segments after it to the storage. Changes are
+     * applied directly and aren't logged once again. Snapshot is loaded by the given number of
+     * threads, see SnapshotStorage::Load.
+     *
+     * Method returns number of applied records. Throws std::runtime_error if log can't be read
+     */
+    std::size_t Replay(std::size_t threads);
+
+private:
+    // Operation codes of log records
+    enum class Operation : uint8_t { kPut = 1, kDelete = 2, kAppend = 4 };
+
+    // Returns true if changes of the key are logged
+    bool Logged(const std::string &key) const { return key.compare(0, _prefix.size(), _prefix) == 0; }
+
+    // Returns lock serializing changes of the key with the given hash
+    std::mutex &Stripe(uint64_t hash);
+
+    // Queues record to be written by the writer thread, returns ticket to wait for in Commit. Must be
+    // called under the stripe lock of the key
+    uint64_t Append(Operation operation, const std::string &key, const std::string &value);
+
+    // Waits until record with the given ticket is on disk, returns false if writing failed
+    bool Commit(uint64_t ticket);
+
+    // Body of the writer thread
+    void OnWrite();
+
+    // Writes and syncs batch of records to the current segment, called by the writer only
+    bool Flush(const std::vector<char> &batch);
+
+    // Switches log to the next segment and forks child writing snapshot, called by the writer only
+    void Compact();
+
+    // Checks if compaction child is done and removes files it made obsolete. Must be called with
+    // _queue_lock held
+    void Reap(bool wait);
+
+    // Lists sequence numbers of files in log directory with the given name
+    std::vector<uint64_t> List(const std::string &name) const;
+
+    // Path to the file in log directory
+    std::string Path(const std::string &name, uint64_t seq) const;
+
+    // Applies records of the single segment to the storage, returns number of them
+    std::size_t ReplaySegment(const std::string &path);
+
+    std::shared_ptr<Afina::Storage> _storage;
+
+    std::string _dir;
+
+    std::string _prefix;
+
+    std::size_t _window;
+
+    std::size_t _compact_bytes;
+
+    // Locks serializing changes of the keys, key goes to the stripe by hash
+    static const std::size_t kStripes = 64;
+    std::mutex _stripes[kStripes];
+
+    KeyHash _hash;
+
+    // Guards all fields below
+    std::mutex _queue_lock;
+
+    // Signals writer about new records and stop
+    std::condition_variable _queue_changed;
+
+    // Signals clients about records written
+    std::condition_variable _committed_changed;
+
+    bool _running;
+
+    // Set once writing fails, operations can't be durable anymore
+    bool _failed;
+
+    // Records waiting to be written
+    std::vector<char> _pending;
+
+    // Tickets of the last queued and the last written records
+    uint64_t _appended;
+    uint64_t _committed;
+
+    std::thread _writer;
+
+    // Current segment, descriptor is used by the writer only
+    int _fd;
+    uint64_t _segment;
+    uint64_t _segment_bytes;
+
+    // Child writing compaction snapshot and the segment that snapshot starts
+    pid_t _child;
+    uint64_t _child_segment;
+
+    // Counters reported in stats
+    uint64_t _records;
+    uint64_t _bytes;
+    uint64_t _commits;
+    uint64_t _compactions;
+    uint64_t _compactions_failed;
+    uint64_t _replayed;
+    uint64_t _replay_torn;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOG_STORAGE_H
@@ -0,0 +1,170 @@
+#include "Lz.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Shortest match worth encoding
+const std::size_t kMinMatch = 4;
+
+// Block always ends with literals, and the last match starts far enough from the end, so that
+// decompressors of the format could copy in wide words without checks
+const std::size_t kLastLiterals = 5;
+const std::size_t kMatchLimit = 12;
+
+// Offset is 16-bit number
+const std::size_t kMaxOffset = 65535;
+
+// Token keeps lengths up to this in 4 bits, longer ones continue in the following bytes
+const std::size_t kShortLength = 15;
+
+// Table of recent positions: 8K entries of 32-bit offsets fit in L1 cache
+const int kHashLog = 13;
+
+inline uint32_t Load32(const char *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t Hash(uint32_t value) { return (value * 2654435761u) >> (32 - kHashLog); }
+
+// Writes the tail of the length which doesn't fit into token
+void WriteLength(std::string &out, std::size_t length) {
+    length -= kShortLength;
+    for (; length >= 255; length -= 255) {
+        out.push_back(char(255));
+    }
+    out.push_back(char(length));
+}
+
+bool ReadLength(const unsigned char *&p, const unsigned char *end, std::size_t &length) {
+    unsigned char byte;
+    do {
+        if (p == end) {
+            return false;
+        }
+        byte = *p++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Writes literals and the match following them, match of zero size ends the block
+void WriteSequence(std::string &out, const char *literals, std::size_t literal_size, std::size_t offset,
+                   std::size_t match_size) {
+    std::size_t match = match_size == 0 ? 0 : match_size - kMinMatch;
+    out.push_back(char((std::min(literal_size, kShortLength) << 4) | std::min(match, kShortLength)));
+    if (literal_size >= kShortLength) {
+        WriteLength(out, literal_size);
+    }
+    out.append(literals, literal_size);
+
+    if (match_size == 0) {
+        return;
+    }
+    out.push_back(char(offset & 0xff));
+    out.push_back(char(offset >> 8));
+    if (match >= kShortLength) {
+        WriteLength(out, match);
+    }
+}
+
+} // namespace
+
+// See Lz.h
+void Lz::Compress(const char *data, std::size_t size, std::string &out) {
+    out.reserve(out.size() + size + size / 255 + 16);
+
+    const char *p = data;
+    const char *anchor = data;
+    const char *end = data + size;
+    if (size > kMatchLimit) {
+        uint32_t table[1 << kHashLog] = {};
+        const char *limit = end - kMatchLimit;
+        const char *match_end = end - kLastLiterals;
+        while (p < limit) {
+            uint32_t sequence = Load32(p);
+            uint32_t &slot = table[Hash(sequence)];
+            const char *ref = data + slot;
+            slot = static_cast<uint32_t>(p - data);
+
+            if (ref >= p || std::size_t(p - ref) > kMaxOffset || Load32(ref) != sequence) {
+                // Step grows while there are no matches, so incompressible data passes quickly
+                p += 1 + ((p - anchor) >> 6);
+                continue;
+            }
+
+            const char *q = p + kMinMatch;
+            for (ref += kMinMatch; q < match_end && *q == *ref; q++, ref++) {
+            }
+            WriteSequence(out, anchor, p - anchor, q - ref, q - p);
+            p = anchor = q;
+        }
+    }
+
+    WriteSequence(out, anchor, end - anchor, 0, 0);
+}
+
+// See Lz.h
+bool Lz::Decompress(const char *data, std::size_t size, std::size_t original_size, std::string &out) {
+    std::size_t start = out.size();
+    out.resize(start + original_size);
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+    const unsigned char *end = p + size;
+    char *begin = &out[0] + start;
+    char *op = begin;
+    char *op_end = begin + original_size;
+    while (p < end) {
+        unsigned char token = *p++;
+        std::size_t literals = token >> 4;
+        if (literals == kShortLength && !ReadLength(p, end, literals)) {
+            return false;
+        }
+        if (literals > std::size_t(end - p) || literals > std::size_t(op_end - op)) {
+            return false;
+        }
+        std::memcpy(op, p, literals);
+        op += literals;
+        p += literals;
+
+        if (p == end) {
+            return op == op_end;
+        }
+        if (end - p < 2) {
+            return false;
+        }
+
+        std::size_t offset = p[0] | (std::size_t(p[1]) << 8);
+        p += 2;
+        std::size_t match = token & 0xf;
+        if (match == kShortLength && !ReadLength(p, end, match)) {
+            return false;
+        }
+        match += kMinMatch;
+        if (offset == 0 || offset > std::size_t(op - begin) || match > std::size_t(op_end - op)) {
+            return false;
+        }
+
+        // Overlapping match repeats the last offset bytes, so copy it byte by byte
+        const char *ref = op - offset;
+        if (offset >= match) {
+            std::memcpy(op, ref, match);
+            op += match;
+        } else {
+            for (char *match_end = op + match; op < match_end;) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,35 @@
+#ifndef AFINA_STORAGE_LZ_H
+#define AFINA_STORAGE_LZ_H
+
+#include <cstddef>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LZ77 block codec
+ * Fast compression in the LZ4 block format: sequences of literals followed by the match in the
+ * previous 64KB of data. Compressor does single greedy pass using small hash table of recent
+ * positions, so it trades ratio for speed, decompressor is a plain copy loop.
+ *
+ * Block doesn't carry size of the original data, caller has to keep it
+ */
+class Lz {
+public:
+    /**
+     * Appends compressed data to the output
+     */
+    static void Compress(const char *data, std::size_t size, std::string &out);
+
+    /**
+     * Appends decompressed data to the output, returns false if block is broken or doesn't
+     * decompress into exactly size bytes. Output content is undefined in that case
+     */
+    static bool Decompress(const char *data, std::size_t size, std::size_t original_size, std::string &out);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LZ_H
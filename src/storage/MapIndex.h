@@ -0,0 +1,85 @@
+#ifndef AFINA_STORAGE_MAP_INDEX_H
+#define AFINA_STORAGE_MAP_INDEX_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Index.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Tree based index
+ * Keeps entries ordered by key, keys are not copied but referenced from entries. Tree nodes come from
+ * the given allocator, e.g. Allocator::StlAllocator to keep them in the pre-reserved area
+ */
+template <typename T, typename Allocator = std::allocator<T *>> class MapIndex : public Index<T> {
+public:
+    explicit MapIndex(const Allocator &allocator = Allocator())
+        : _map(std::less<std::string>(), MapAllocator(allocator)) {}
+    ~MapIndex() {}
+
+    // See Index.h
+    T *Find(const std::string &key) override {
+        auto it = _map.find(std::cref(key));
+        if (it == _map.end()) {
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    // See Index.h
+    void Insert(T *entry) override { _map.emplace(std::cref(entry->key), entry); }
+
+    // See Index.h
+    T *Erase(const std::string &key) override {
+        auto it = _map.find(std::cref(key));
+        if (it == _map.end()) {
+            return nullptr;
+        }
+
+        T *result = it->second;
+        _map.erase(it);
+        return result;
+    }
+
+    // See Index.h
+    void Clear() override { _map.clear(); }
+
+    // See Index.h
+    std::size_t Size() const override { return _map.size(); }
+
+    // See Index.h
+    bool Walk(const std::string &prefix, const std::string &after, const std::function<bool(T *)> &visit) override {
+        auto it = _map.lower_bound(std::cref((after > prefix) ? after : prefix));
+        for (; it != _map.end(); ++it) {
+            const std::string &key = it->first;
+            if (!after.empty() && key == after) {
+                continue;
+            }
+            if (key.compare(0, prefix.size(), prefix) != 0 || !visit(it->second)) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    // See Index.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) const override {
+        stats.emplace_back("index_type", "map");
+    }
+
+private:
+    using Key = std::reference_wrapper<const std::string>;
+    using MapAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const Key, T *>>;
+
+    std::map<Key, T *, std::less<std::string>, MapAllocator> _map;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAP_INDEX_H
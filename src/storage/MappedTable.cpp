@@ -0,0 +1,252 @@
+#include "MappedTable.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char kMagic[8] = {'A', 'F', 'I', 'N', 'A', 'T', 'B', '1'};
+
+struct Header {
+    char magic[8];
+    uint64_t items;
+    uint64_t index;
+    uint64_t size;
+};
+
+// Key size and value size in front of each record
+const std::size_t kRecordHeader = 2 * sizeof(uint32_t);
+
+// Size of the buffer used to write table
+const std::size_t kWriteBuffer = 1 << 20;
+
+} // namespace
+
+// See MappedTable.h
+MappedTable::MappedTable(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open table " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Failed to stat table " + path + ": " + std::strerror(error));
+    }
+
+    _size = st.st_size;
+    if (_size < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error("Table " + path + " is truncated");
+    }
+
+    // Shared mapping of the read only file, so all processes use the same page cache pages
+    void *data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map table " + path + ": " + std::strerror(error));
+    }
+    _data = static_cast<const char *>(data);
+    madvise(data, _size, MADV_RANDOM);
+
+    Header header;
+    std::memcpy(&header, _data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.size != _size ||
+        header.index < sizeof(Header) || header.index > _size ||
+        (_size - header.index) != header.items * sizeof(uint64_t)) {
+        munmap(data, _size);
+        throw std::runtime_error("Table " + path + " is broken");
+    }
+
+    _items = header.items;
+    _index = _data + header.index;
+}
+
+// See MappedTable.h
+MappedTable::~MappedTable() { munmap(const_cast<char *>(_data), _size); }
+
+// See MappedTable.h
+bool MappedTable::Get(const std::string &key, std::string &value) {
+    uint64_t i = LowerBound(key);
+    if (i == _items) {
+        return false;
+    }
+
+    const char *k, *v;
+    uint32_t key_size, value_size;
+    Record(i, k, key_size, v, value_size);
+    if (key.size() != key_size || std::memcmp(key.data(), k, key_size) != 0) {
+        return false;
+    }
+
+    value.assign(v, value_size);
+    return true;
+}
+
+// See MappedTable.h
+bool MappedTable::Scan(const std::string &prefix, const std::string &after, std::size_t count,
+                       std::vector<std::string> &keys) {
+    const char *k, *v;
+    uint32_t key_size, value_size;
+    for (uint64_t i = LowerBound(std::max(after, prefix)); i < _items && count > 0; i++) {
+        Record(i, k, key_size, v, value_size);
+        if (key_size < prefix.size() || std::memcmp(k, prefix.data(), prefix.size()) != 0) {
+            break;
+        }
+        if (!after.empty() && after.compare(0, std::string::npos, k, key_size) == 0) {
+            continue;
+        }
+
+        keys.emplace_back(k, key_size);
+        count--;
+    }
+    return true;
+}
+
+// See MappedTable.h
+void MappedTable::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_items));
+    stats.emplace_back("table_bytes", std::to_string(_size));
+}
+
+// See MappedTable.h
+pid_t MappedTable::Fork() { return fork(); }
+
+// See MappedTable.h
+bool MappedTable::Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+    const char *k, *v;
+    uint32_t key_size, value_size;
+    std::string key, value;
+    for (uint64_t i = 0; i < _items; i++) {
+        Record(i, k, key_size, v, value_size);
+        key.assign(k, key_size);
+        value.assign(v, value_size);
+        visit(0, key, value);
+    }
+    return true;
+}
+
+// See MappedTable.h
+void MappedTable::Record(uint64_t i, const char *&key, uint32_t &key_size, const char *&value,
+                         uint32_t &value_size) const {
+    uint64_t offset;
+    std::memcpy(&offset, _index + i * sizeof(uint64_t), sizeof(offset));
+
+    // Records must lay between the header and the index
+    uint64_t limit = _index - _data;
+    uint32_t sizes[2];
+    if (offset < sizeof(Header) || offset > limit - kRecordHeader) {
+        throw std::runtime_error("Table record is out of bounds");
+    }
+    std::memcpy(sizes, _data + offset, sizeof(sizes));
+    if (uint64_t(sizes[0]) + sizes[1] > limit - offset - kRecordHeader) {
+        throw std::runtime_error("Table record is out of bounds");
+    }
+
+    key = _data + offset + kRecordHeader;
+    key_size = sizes[0];
+    value = key + key_size;
+    value_size = sizes[1];
+}
+
+// See MappedTable.h
+uint64_t MappedTable::LowerBound(const std::string &key) const {
+    const char *k, *v;
+    uint32_t key_size, value_size;
+
+    uint64_t low = 0, high = _items;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        Record(middle, k, key_size, v, value_size);
+        if (key.compare(0, std::string::npos, k, key_size) > 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// See MappedTable.h
+MappedTableWriter::MappedTableWriter(const std::string &path)
+    : _path(path), _offset(sizeof(Header)), _buffer(kWriteBuffer) {
+    _file = std::fopen((_path + ".tmp").c_str(), "wb");
+    if (_file == nullptr) {
+        throw std::runtime_error("Failed to create table " + _path + ": " + std::strerror(errno));
+    }
+    std::setvbuf(_file, _buffer.data(), _IOFBF, _buffer.size());
+
+    // Header is written once the index position is known
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    Write(&header, sizeof(header));
+}
+
+// See MappedTable.h
+MappedTableWriter::~MappedTableWriter() {
+    if (_file != nullptr) {
+        std::fclose(_file);
+        unlink((_path + ".tmp").c_str());
+    }
+}
+
+// See MappedTable.h
+void MappedTableWriter::Add(const char *key, uint32_t key_size, const char *value, uint32_t value_size) {
+    if (!_offsets.empty() && _last.compare(0, std::string::npos, key, key_size) >= 0) {
+        throw std::runtime_error("Table keys must be added in ascending order");
+    }
+    _last.assign(key, key_size);
+    _offsets.push_back(_offset);
+
+    uint32_t sizes[2] = {key_size, value_size};
+    Write(sizes, sizeof(sizes));
+    Write(key, key_size);
+    Write(value, value_size);
+    _offset += sizeof(sizes) + key_size + value_size;
+}
+
+// See MappedTable.h
+void MappedTableWriter::Finish() {
+    Write(_offsets.data(), _offsets.size() * sizeof(uint64_t));
+
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.items = _offsets.size();
+    header.index = _offset;
+    header.size = _offset + _offsets.size() * sizeof(uint64_t);
+    if (std::fseek(_file, 0, SEEK_SET) != 0) {
+        throw std::runtime_error("Failed to write table " + _path + ": " + std::strerror(errno));
+    }
+    Write(&header, sizeof(header));
+
+    bool ok = std::fflush(_file) == 0 && fsync(fileno(_file)) == 0;
+    ok = (std::fclose(_file) == 0) && ok;
+    _file = nullptr;
+    if (!ok || std::rename((_path + ".tmp").c_str(), _path.c_str()) != 0) {
+        unlink((_path + ".tmp").c_str());
+        throw std::runtime_error("Failed to write table " + _path + ": " + std::strerror(errno));
+    }
+}
+
+// See MappedTable.h
+void MappedTableWriter::Write(const void *data, std::size_t size) {
+    if (size > 0 && std::fwrite(data, size, 1, _file) != 1) {
+        throw std::runtime_error("Failed to write table " + _path + ": " + std::strerror(errno));
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
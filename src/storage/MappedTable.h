@@ -0,0 +1,126 @@
+#ifndef AFINA_STORAGE_MAPPED_TABLE_H
+#define AFINA_STORAGE_MAPPED_TABLE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Immutable dataset
+ * Serves read only table built offline by MappedTableWriter. File is mapped into memory as is and
+ * lookups go straight to the mapped pages, so opening the table takes no time regardless of its
+ * size, data takes no heap and page cache is shared by all processes serving the same file.
+ *
+ * File starts with the header: magic, number of items, offset of the index and the file size as
+ * 64-bit numbers. Records sorted by key follow, each is key size and value size as 32-bit numbers
+ * followed by key and value bytes. File ends with the index: offsets of all records as 64-bit
+ * numbers, Get does binary search over it. Numbers are in the native byte order.
+ *
+ * All modifications fail, reads are thread safe without any locking. Broken record makes operation
+ * throw std::runtime_error
+ */
+class MappedTable : public Afina::Storage {
+public:
+    /**
+     * Maps the table, throws std::runtime_error if file can't be mapped or is broken
+     */
+    MappedTable(const std::string &path);
+    ~MappedTable();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return false; }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override { return false; }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return false; }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return false; }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override;
+
+private:
+    // Reads record with the given number
+    void Record(uint64_t i, const char *&key, uint32_t &key_size, const char *&value, uint32_t &value_size) const;
+
+    // Number of the first record with the key not less than the given one
+    uint64_t LowerBound(const std::string &key) const;
+
+    const char *_data;
+
+    std::size_t _size;
+
+    uint64_t _items;
+
+    // Index of the records, points into the mapping
+    const char *_index;
+};
+
+/**
+ * # Builder of the immutable dataset
+ * Writes file for MappedTable. Records must be added in ascending order of keys, file appears at
+ * the given path atomically once Finish is called. Only the index is kept in memory while writing.
+ *
+ * All methods throw std::runtime_error on failures
+ */
+class MappedTableWriter {
+public:
+    MappedTableWriter(const std::string &path);
+    ~MappedTableWriter();
+
+    /**
+     * Appends record, key must be greater than the key of the previous one
+     */
+    void Add(const char *key, uint32_t key_size, const char *value, uint32_t value_size);
+
+    void Add(const std::string &key, const std::string &value) {
+        Add(key.data(), key.size(), value.data(), value.size());
+    }
+
+    /**
+     * Writes index and makes file visible at the target path
+     */
+    void Finish();
+
+private:
+    void Write(const void *data, std::size_t size);
+
+    std::string _path;
+
+    std::FILE *_file;
+
+    std::vector<uint64_t> _offsets;
+
+    uint64_t _offset;
+
+    std::string _last;
+
+    std::vector<char> _buffer;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAPPED_TABLE_H
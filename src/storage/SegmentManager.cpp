@@ -0,0 +1,182 @@
+#include "SegmentManager.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Key size and value size in front of each record
+const std::size_t kRecordHeader = 2 * sizeof(uint32_t);
+
+} // namespace
+
+// See SegmentManager.h
+SegmentManager::SegmentManager(const std::string &dir, std::size_t segment_size)
+    : _dir(dir), _segment_size(segment_size), _next_segment(0), _live(0) {
+    if (mkdir(_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create segments directory " + _dir + ": " + std::strerror(errno));
+    }
+}
+
+// See SegmentManager.h
+SegmentManager::~SegmentManager() {
+    for (auto &segment : _segments) {
+        munmap(segment.second.data, _segment_size);
+    }
+}
+
+// See SegmentManager.h
+bool SegmentManager::Append(const std::string &key, const std::string &value, Location &location) {
+    std::size_t size = kRecordHeader + key.size() + value.size();
+    if (size > _segment_size) {
+        return false;
+    }
+
+    if (_segments.empty() || _segments.rbegin()->second.used + size > _segment_size) {
+        if (!Create()) {
+            return false;
+        }
+    }
+
+    auto &last = *_segments.rbegin();
+    Segment &segment = last.second;
+    uint32_t sizes[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+    char *p = segment.data + segment.used;
+    std::memcpy(p, sizes, sizeof(sizes));
+    std::memcpy(p + kRecordHeader, key.data(), key.size());
+    std::memcpy(p + kRecordHeader + key.size(), value.data(), value.size());
+
+    location.segment = last.first;
+    location.offset = segment.used;
+    segment.used += size;
+    segment.live += size;
+    _live += size;
+    return true;
+}
+
+// See SegmentManager.h
+void SegmentManager::Read(const Location &location, std::string &value) const {
+    const char *p = _segments.at(location.segment).data + location.offset;
+    uint32_t sizes[2];
+    std::memcpy(sizes, p, sizeof(sizes));
+    value.assign(p + kRecordHeader + sizes[0], sizes[1]);
+}
+
+// See SegmentManager.h
+void SegmentManager::Release(const Location &location) {
+    Segment &segment = _segments.at(location.segment);
+    uint32_t sizes[2];
+    std::memcpy(sizes, segment.data + location.offset, sizeof(sizes));
+
+    std::size_t size = kRecordHeader + sizes[0] + sizes[1];
+    segment.live -= size;
+    _live -= size;
+}
+
+// See SegmentManager.h
+bool SegmentManager::Next(uint32_t segment, uint32_t &cursor, std::string &key, Location &location) const {
+    const Segment &s = _segments.at(segment);
+    if (cursor >= s.used) {
+        return false;
+    }
+
+    uint32_t sizes[2];
+    std::memcpy(sizes, s.data + cursor, sizeof(sizes));
+    key.assign(s.data + cursor + kRecordHeader, sizes[0]);
+
+    location.segment = segment;
+    location.offset = cursor;
+    cursor += kRecordHeader + sizes[0] + sizes[1];
+    return true;
+}
+
+// See SegmentManager.h
+bool SegmentManager::Victim(uint32_t &segment) const {
+    if (_segments.size() < 2) {
+        return false;
+    }
+
+    // The last segment is still being filled, it is never compacted
+    auto end = std::prev(_segments.end());
+    std::size_t best = _segment_size / 2;
+    bool found = false;
+    for (auto it = _segments.begin(); it != end; ++it) {
+        if (it->second.live < best) {
+            best = it->second.live;
+            segment = it->first;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// See SegmentManager.h
+std::vector<uint32_t> SegmentManager::List() const {
+    std::vector<uint32_t> result;
+    for (auto &segment : _segments) {
+        result.push_back(segment.first);
+    }
+    return result;
+}
+
+// See SegmentManager.h
+bool SegmentManager::Oldest(uint32_t &segment) const {
+    if (_segments.size() < 2) {
+        return false;
+    }
+
+    segment = _segments.begin()->first;
+    return true;
+}
+
+// See SegmentManager.h
+void SegmentManager::Drop(uint32_t segment) {
+    auto it = _segments.find(segment);
+    if (it == _segments.end()) {
+        return;
+    }
+
+    munmap(it->second.data, _segment_size);
+    _live -= it->second.live;
+    _segments.erase(it);
+}
+
+// See SegmentManager.h
+bool SegmentManager::Create() {
+    std::string path = _dir + "/segment." + std::to_string(getpid()) + "." + std::to_string(_next_segment);
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+
+    // File lives while it is mapped
+    unlink(path.c_str());
+    if (ftruncate(fd, _segment_size) != 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, _segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    // Values are read back at random, read ahead only wastes page cache
+    madvise(data, _segment_size, MADV_RANDOM);
+    _segments.emplace(_next_segment++, Segment{static_cast<char *>(data), 0, 0});
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
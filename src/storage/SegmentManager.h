@@ -0,0 +1,129 @@
+#ifndef AFINA_STORAGE_SEGMENT_MANAGER_H
+#define AFINA_STORAGE_SEGMENT_MANAGER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Log structured file storage
+ * Keeps key/value records in the sequence of fixed size segment files mapped into memory. Records
+ * are only appended to the last segment, once it is full the next one gets created. Removed and
+ * overwritten records stay in place as garbage, compaction copies live records of the segment to
+ * the end of the log and drops the segment entirely.
+ *
+ * Mappings are shared with the page cache, so the data takes no heap and kernel writes it back and
+ * reclaims it under memory pressure. Files are scratch space unlinked right after creation, so the
+ * data doesn't survive restart and nothing is left behind after crash.
+ *
+ * Class isn't thread safe
+ */
+class SegmentManager {
+public:
+    /**
+     * Place of the record in the log
+     */
+    struct Location {
+        uint32_t segment;
+        uint32_t offset;
+
+        bool operator==(const Location &other) const {
+            return segment == other.segment && offset == other.offset;
+        }
+    };
+
+    /**
+     * @param dir directory to create segment files in, created if doesn't exist
+     * @param segment_size size of the single segment file
+     */
+    SegmentManager(const std::string &dir, std::size_t segment_size);
+    ~SegmentManager();
+
+    /**
+     * Appends record to the log. Returns false if record is larger than the segment
+     */
+    bool Append(const std::string &key, const std::string &value, Location &location);
+
+    /**
+     * Copies value of the record into the given output
+     */
+    void Read(const Location &location, std::string &value) const;
+
+    /**
+     * Marks record as garbage, so that compaction knows how much space segment wastes
+     */
+    void Release(const Location &location);
+
+    /**
+     * Iterates records of the segment, both live and garbage ones. Cursor must be zero to start
+     * from the first record, returns false once there are no more records
+     */
+    bool Next(uint32_t segment, uint32_t &cursor, std::string &key, Location &location) const;
+
+    /**
+     * Returns full segment which wastes the most of space, if that is more than half of the segment.
+     * Returns false if there is no such segment
+     */
+    bool Victim(uint32_t &segment) const;
+
+    /**
+     * Returns ids of all segments from the oldest one
+     */
+    std::vector<uint32_t> List() const;
+
+    /**
+     * Returns the oldest segment, false if there are no full segments
+     */
+    bool Oldest(uint32_t &segment) const;
+
+    /**
+     * Removes segment together with all of its records
+     */
+    void Drop(uint32_t segment);
+
+    /**
+     * Total size of segment files
+     */
+    std::size_t Size() const { return _segments.size() * _segment_size; }
+
+    /**
+     * Bytes taken by live records
+     */
+    std::size_t Live() const { return _live; }
+
+    /**
+     * Number of segment files
+     */
+    std::size_t Segments() const { return _segments.size(); }
+
+private:
+    struct Segment {
+        char *data;
+        uint32_t used;
+        uint32_t live;
+    };
+
+    // Creates new segment for appends, returns false if fails
+    bool Create();
+
+    std::string _dir;
+
+    std::size_t _segment_size;
+
+    // Segments by id, the last one is open for appends
+    std::map<uint32_t, Segment> _segments;
+
+    uint32_t _next_segment;
+
+    std::size_t _live;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SEGMENT_MANAGER_H
@@ -0,0 +1,197 @@
+#include "ShardedLRU.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+// See ShardedLRU.h
+ShardedLRU::ShardedLRU(size_t shards, size_t max_size, IndexType index, bool filter) {
+    if (shards == 0) {
+        throw std::runtime_error("Storage must have at least one shard");
+    }
+
+    for (size_t i = 0; i < shards; i++) {
+        _shards.emplace_back(new ThreadSafeSimplLRU(max_size / shards, index, filter));
+    }
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Start() {
+    for (auto &shard : _shards) {
+        shard->Start();
+    }
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Stop() {
+    for (auto &shard : _shards) {
+        shard->Stop();
+    }
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Put(const std::string &key, const std::string &value) { return Put(key, _hash(key), value); }
+
+// See ShardedLRU.h
+bool ShardedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsent(key, _hash(key), value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Set(const std::string &key, const std::string &value) { return Set(key, _hash(key), value); }
+
+// See ShardedLRU.h
+bool ShardedLRU::Delete(const std::string &key) { return Shard(_hash(key)).Delete(key); }
+
+// See ShardedLRU.h
+bool ShardedLRU::Get(const std::string &key, std::string &value) { return Get(key, _hash(key), value); }
+
+// See ShardedLRU.h
+bool ShardedLRU::GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) {
+    return GetChunks(key, _hash(key), chunks);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Append(const std::string &key, const std::string &data) { return Append(key, _hash(key), data); }
+
+// See ShardedLRU.h
+bool ShardedLRU::Put(const std::string &key, uint64_t hash, const std::string &value) {
+    return Shard(hash).Put(key, hash, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) {
+    return Shard(hash).PutIfAbsent(key, hash, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Set(const std::string &key, uint64_t hash, const std::string &value) {
+    return Shard(hash).Set(key, hash, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Get(const std::string &key, uint64_t hash, std::string &value) {
+    return Shard(hash).Get(key, hash, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::GetChunks(const std::string &key, uint64_t hash,
+                           std::vector<std::shared_ptr<const std::string>> &chunks) {
+    return Shard(hash).GetChunks(key, hash, chunks);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Append(const std::string &key, uint64_t hash, const std::string &data) {
+    return Shard(hash).Append(key, hash, data);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Scan(const std::string &prefix, const std::string &after, std::size_t count,
+                      std::vector<std::string> &keys) {
+    // Each shard returns its own first keys after the cursor, merge them and take first ones
+    std::vector<std::string> merged;
+    for (auto &shard : _shards) {
+        if (!shard->Scan(prefix, after, count, merged)) {
+            return false;
+        }
+    }
+
+    std::sort(merged.begin(), merged.end());
+    if (merged.size() > count) {
+        merged.resize(count);
+    }
+
+    keys.insert(keys.end(), merged.begin(), merged.end());
+    return true;
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) {
+    deleted = 0;
+    for (auto &shard : _shards) {
+        std::size_t removed = 0;
+        if (!shard->DeletePrefix(prefix, count - deleted, removed)) {
+            return false;
+        }
+
+        deleted += removed;
+        if (deleted == count) {
+            break;
+        }
+    }
+    return true;
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Resize(std::size_t max_size) {
+    for (auto &shard : _shards) {
+        shard->Resize(max_size / _shards.size());
+    }
+    return true;
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    // Counters summed over all shards
+    std::vector<std::pair<std::string, uint64_t>> totals = {
+        {"curr_items", 0},     {"bytes", 0},           {"limit_maxbytes", 0},   {"evictions", 0},
+        {"evictions_inline", 0}, {"evictions_background", 0}, {"filter_negatives", 0}, {"filter_false_positives", 0}};
+
+    std::vector<std::pair<std::string, std::string>> shards;
+    for (std::size_t i = 0; i < _shards.size(); i++) {
+        std::vector<std::pair<std::string, std::string>> shard;
+        _shards[i]->Stats(shard);
+
+        for (auto &stat : shard) {
+            for (auto &total : totals) {
+                if (total.first == stat.first) {
+                    total.second += std::strtoull(stat.second.c_str(), nullptr, 10);
+                }
+            }
+            shards.emplace_back("shard" + std::to_string(i) + ":" + stat.first, stat.second);
+        }
+    }
+
+    stats.emplace_back("shards", std::to_string(_shards.size()));
+    for (auto &total : totals) {
+        stats.emplace_back(total.first, std::to_string(total.second));
+    }
+    stats.insert(stats.end(), shards.begin(), shards.end());
+}
+
+// See ShardedLRU.h
+pid_t ShardedLRU::Fork() {
+    // Locks are always taken in the same order, nothing else holds more than one of them
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto &shard : _shards) {
+        locks.push_back(shard->Quiesce());
+    }
+    return fork();
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+    for (std::size_t i = 0; i < _shards.size(); i++) {
+        bool result = _shards[i]->Dump([i, &visit](std::size_t, const std::string &key, const std::string &value) {
+            visit(i, key, value);
+        });
+        if (!result) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// See ShardedLRU.h
+ThreadSafeSimplLRU &ShardedLRU::Shard(uint64_t hash) {
+    // Shard indexes use lower bits of the same hash, so take upper ones here
+    return *_shards[(hash >> 32) % _shards.size()];
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,105 @@
+#ifndef AFINA_STORAGE_SHARDED_LRU_H
+#define AFINA_STORAGE_SHARDED_LRU_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "KeyHash.h"
+#include "ThreadSafeSimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Sharded LRU
+ * Splits keys between number of independent ThreadSafeSimplLRU shards by key hash. Each shard has
+ * its own lock, index, filter and background maintenance, so operations on different shards
+ * don't contend. Memory limit is split evenly between shards and LRU order is maintained per shard
+ */
+class ShardedLRU : public Afina::Storage {
+public:
+    ShardedLRU(size_t shards = 8, size_t max_size = 1024, IndexType index = IndexType::kMap, bool filter = false);
+    ~ShardedLRU() {}
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, shard is picked by the given hash
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override;
+
+    // Implements Afina::Storage interface
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override;
+
+    // Implements Afina::Storage interface, limit is split evenly between shards
+    bool Resize(std::size_t max_size) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override;
+
+    // Implements Afina::Storage interface, each shard is a separate part
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override;
+
+private:
+    // Returns shard responsible for the key with the given hash
+    ThreadSafeSimplLRU &Shard(uint64_t hash);
+
+    KeyHash _hash;
+
+    std::vector<std::unique_ptr<ThreadSafeSimplLRU>> _shards;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_LRU_H
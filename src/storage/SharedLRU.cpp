@@ -0,0 +1,513 @@
+#include "SharedLRU.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/HugePages.h>
+#include <afina/allocator/Pointer.h>
+
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+// Cache state in the segment, allocated first and registered as the allocator root. References
+// are allocator handles, so they survive compaction. Nodes refer to each other by compact handles
+// of 32 bits, see Allocator::Simple::compact, which makes metadata of small items about a third
+// smaller than with 64-bit offsets
+struct SharedLRU::Root {
+    uint64_t magic;
+
+    // kOpen while some process uses the segment, kClosed once it detached cleanly
+    uint64_t state;
+
+    // Index: offset of the array of chain heads
+    uint64_t buckets;
+    uint64_t bucket_count;
+
+    uint64_t items;
+    uint64_t bytes;
+    uint64_t evictions;
+    uint64_t defrag_steps;
+    uint64_t defrag_bytes;
+
+    // List ordered by "freshness", the least recently used node in the head
+    uint32_t head;
+    uint32_t tail;
+};
+
+// Item, key and value follow the structure
+struct SharedLRU::Node {
+    uint32_t prev;
+    uint32_t next;
+
+    // Next node in the index chain
+    uint32_t chain;
+
+    uint32_t hash;
+    uint32_t key_size;
+    uint32_t value_size;
+
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+};
+
+namespace {
+
+// "AFSHLRU5", changes with the layout of Root and Node or the key hash
+const uint64_t kMagic = 0x3555524c48534641ull;
+
+const uint64_t kOpen = 1;
+const uint64_t kClosed = 2;
+
+// Segment bytes per index bucket
+const std::size_t kBytesPerBucket = 256;
+
+// Largest item is this part of the segment
+const std::size_t kMaxItemPart = 4;
+
+// Segment gets compacted once free memory is at least this part of it and at least kDefragRatio of
+// free memory is outside of the largest free block
+const std::size_t kDefragPart = 8;
+const double kDefragRatio = 0.5;
+
+// Budget of the single compaction step taken under the lock: bytes to move and microseconds
+const std::size_t kDefragStepBytes = 256 << 10;
+const std::size_t kDefragStepTime = 200;
+
+} // namespace
+
+// See SharedLRU.h
+SharedLRU::SharedLRU(const std::string &name, std::size_t size, bool huge_pages, bool buddy)
+    : _name(name), _data(nullptr), _size(size), _huge_pages(huge_pages), _root(nullptr), _attached(false),
+      _running(false), _defrag_scheduled(false) {
+    _fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd < 0) {
+        throw std::runtime_error("Failed to open shared memory " + name + ": " + std::strerror(errno));
+    }
+
+    // Lock is released by the kernel once owner exits, however it does
+    int result;
+    while ((result = flock(_fd, LOCK_EX)) != 0 && errno == EINTR) {
+    }
+
+    struct stat st;
+    if (result != 0 || fstat(_fd, &st) != 0 || (std::size_t(st.st_size) != size && ftruncate(_fd, size) != 0)) {
+        int error = errno;
+        close(_fd);
+        throw std::runtime_error("Failed to prepare shared memory " + name + ": " + std::strerror(error));
+    }
+
+    _data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (_data == MAP_FAILED) {
+        int error = errno;
+        close(_fd);
+        throw std::runtime_error("Failed to map shared memory " + name + ": " + std::strerror(error));
+    }
+
+    // Shared memory gets huge pages only if shmem_enabled of THP allows advice, hugetlbfs isn't used as
+    // segment must stay an ordinary shm object other processes could open
+    if (huge_pages) {
+        madvise(_data, size, MADV_HUGEPAGE);
+    }
+
+    // Cache is reused only if the previous owner didn't crash in the middle of some operation
+    _allocator.reset(new Allocator::Simple(_data, size, std::size_t(st.st_size) == size));
+    if (_allocator->attached() && _allocator->root() != 0) {
+        _root = static_cast<Root *>(_allocator->get(_allocator->root()).get());
+        _attached = _root->magic == kMagic && _root->state == kClosed;
+    }
+
+    if (!_attached) {
+        _allocator.reset(new Allocator::Simple(_data, size));
+        Format();
+    }
+    _allocator->buddy(buddy);
+    _root->state = kOpen;
+}
+
+// See SharedLRU.h
+SharedLRU::~SharedLRU() {
+    Stop();
+    std::unique_lock<std::mutex> lock(_lock);
+    _root->state = kClosed;
+    munmap(_data, _size);
+    close(_fd);
+}
+
+// See SharedLRU.h
+void SharedLRU::Start() {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_running) {
+        return;
+    }
+
+    _running = true;
+    _executor.reset(new Concurrency::Executor("shm-defrag", 1));
+    ScheduleDefrag();
+}
+
+// See SharedLRU.h
+void SharedLRU::Stop() {
+    std::unique_ptr<Concurrency::Executor> executor;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _running = false;
+        executor = std::move(_executor);
+    }
+
+    if (executor) {
+        executor->Stop(true);
+    }
+}
+
+// See SharedLRU.h
+bool SharedLRU::Remove(const std::string &name) { return shm_unlink(name.c_str()) == 0; }
+
+// See SharedLRU.h
+bool SharedLRU::Put(const std::string &key, const std::string &value) {
+    if (!Fits(key, value)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t hash = uint32_t(KeyHash::Compute(key.data(), key.size()));
+    uint32_t *slot = Link(key.data(), key.size(), hash);
+    if (*slot != 0) {
+        Remove(slot);
+    }
+    return Insert(key, value, hash);
+}
+
+// See SharedLRU.h
+bool SharedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (!Fits(key, value)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t hash = uint32_t(KeyHash::Compute(key.data(), key.size()));
+    if (*Link(key.data(), key.size(), hash) != 0) {
+        return false;
+    }
+    return Insert(key, value, hash);
+}
+
+// See SharedLRU.h
+bool SharedLRU::Set(const std::string &key, const std::string &value) {
+    if (!Fits(key, value)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t hash = uint32_t(KeyHash::Compute(key.data(), key.size()));
+    uint32_t *slot = Link(key.data(), key.size(), hash);
+    if (*slot == 0) {
+        return false;
+    }
+
+    Remove(slot);
+    return Insert(key, value, hash);
+}
+
+// See SharedLRU.h
+bool SharedLRU::Delete(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t *slot = Link(key.data(), key.size(), uint32_t(KeyHash::Compute(key.data(), key.size())));
+    if (*slot == 0) {
+        return false;
+    }
+
+    Remove(slot);
+    return true;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Get(const std::string &key, std::string &value) {
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t handle = *Link(key.data(), key.size(), uint32_t(KeyHash::Compute(key.data(), key.size())));
+    if (handle == 0) {
+        return false;
+    }
+
+    Node *node = ToNode(handle);
+    value.assign(node->data() + node->key_size, node->value_size);
+    MoveToTail(handle);
+    return true;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Append(const std::string &key, const std::string &data) {
+    std::unique_lock<std::mutex> lock(_lock);
+    uint32_t hash = uint32_t(KeyHash::Compute(key.data(), key.size()));
+    uint32_t handle = *Link(key.data(), key.size(), hash);
+    if (handle == 0) {
+        return false;
+    }
+
+    std::size_t value_size = ToNode(handle)->value_size + data.size();
+    if (key.size() + value_size > _size / kMaxItemPart || value_size > UINT32_MAX) {
+        return false;
+    }
+
+    // Item is the freshest one, so eviction below takes it the last. Handle stays the same when item
+    // moves, so links to it don't change
+    MoveToTail(handle);
+    Allocator::Pointer pointer = _allocator->get(_allocator->expand(handle));
+    std::size_t size = sizeof(Node) + key.size() + value_size;
+    bool compacted = false;
+    for (;;) {
+        try {
+            _allocator->realloc(pointer, size);
+            break;
+        } catch (Allocator::AllocError &) {
+            if (!compacted && _allocator->available() >= size && Fragmented()) {
+                compacted = true;
+                Compact();
+                continue;
+            }
+            if (_root->head == handle) {
+                return false;
+            }
+
+            Node *victim = ToNode(_root->head);
+            Remove(Link(victim->data(), victim->key_size, victim->hash));
+            _root->evictions++;
+        }
+    }
+
+    Node *node = static_cast<Node *>(pointer.get());
+    std::memcpy(node->data() + node->key_size + node->value_size, data.data(), data.size());
+    node->value_size = value_size;
+    _root->bytes += data.size();
+    return true;
+}
+
+// See SharedLRU.h
+void SharedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::unique_lock<std::mutex> lock(_lock);
+    stats.emplace_back("curr_items", std::to_string(_root->items));
+    stats.emplace_back("bytes", std::to_string(_root->bytes));
+    stats.emplace_back("limit_maxbytes", std::to_string(_size));
+    stats.emplace_back("evictions", std::to_string(_root->evictions));
+    stats.emplace_back("shm_attached", _attached ? "1" : "0");
+    stats.emplace_back("shm_used_bytes", std::to_string(_allocator->used()));
+    stats.emplace_back("shm_fragmentation", std::to_string(_allocator->fragmentation()));
+    stats.emplace_back("shm_defrag_steps", std::to_string(_root->defrag_steps));
+    stats.emplace_back("shm_defrag_bytes", std::to_string(_root->defrag_bytes));
+    stats.emplace_back("shm_buckets", std::to_string(_root->bucket_count));
+    stats.emplace_back("shm_hugepages", _huge_pages ? "1" : "0");
+    stats.emplace_back("shm_hugepage_bytes", std::to_string(Allocator::HugePageBytes(_data, _size)));
+}
+
+// See SharedLRU.h
+void SharedLRU::AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::string dump;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        dump = _allocator->dump();
+    }
+
+    for (std::size_t begin = 0, end; begin < dump.size(); begin = end + 1) {
+        end = dump.find('\n', begin);
+        std::size_t space = dump.find(' ', begin);
+        stats.emplace_back("shm_" + dump.substr(begin, space - begin), dump.substr(space + 1, end - space - 1));
+    }
+}
+
+// See SharedLRU.h
+bool SharedLRU::Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+    std::unique_lock<std::mutex> lock(_lock);
+    std::string key, value;
+    for (uint32_t handle = _root->head; handle != 0;) {
+        Node *node = ToNode(handle);
+        key.assign(node->data(), node->key_size);
+        value.assign(node->data() + node->key_size, node->value_size);
+        visit(0, key, value);
+        handle = node->next;
+    }
+    return true;
+}
+
+// See SharedLRU.h
+void SharedLRU::Format() {
+    Allocator::Pointer root = _allocator->alloc(sizeof(Root));
+    _root = static_cast<Root *>(root.get());
+    std::memset(_root, 0, sizeof(Root));
+    _root->magic = kMagic;
+
+    _root->bucket_count = 1;
+    while (_root->bucket_count * kBytesPerBucket < _size) {
+        _root->bucket_count *= 2;
+    }
+
+    Allocator::Pointer buckets = _allocator->alloc(_root->bucket_count * sizeof(uint32_t));
+    std::memset(buckets.get(), 0, _root->bucket_count * sizeof(uint32_t));
+    _root->buckets = buckets.offset();
+
+    // Root gets registered last, so that crash in between leaves segment without root
+    _allocator->root(root);
+}
+
+// See SharedLRU.h
+bool SharedLRU::Fits(const std::string &key, const std::string &value) const {
+    return key.size() + value.size() <= _size / kMaxItemPart && value.size() <= UINT32_MAX;
+}
+
+// See SharedLRU.h
+SharedLRU::Node *SharedLRU::ToNode(uint32_t handle) const {
+    return static_cast<Node *>(_allocator->get(_allocator->expand(handle)).get());
+}
+
+// See SharedLRU.h
+uint32_t *SharedLRU::Link(const char *key, uint32_t key_size, uint32_t hash) {
+    uint32_t *buckets = static_cast<uint32_t *>(_allocator->get(_root->buckets).get());
+    uint32_t *slot = &buckets[hash & (_root->bucket_count - 1)];
+    while (*slot != 0) {
+        Node *node = ToNode(*slot);
+        if (node->hash == hash && node->key_size == key_size && KeyHash::Equal(node->data(), key, key_size)) {
+            break;
+        }
+        slot = &node->chain;
+    }
+    return slot;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Insert(const std::string &key, const std::string &value, uint32_t hash) {
+    std::size_t size = sizeof(Node) + key.size() + value.size();
+    Allocator::Pointer pointer;
+    bool compacted = false;
+    while (pointer.offset() == 0) {
+        try {
+            pointer = _allocator->alloc(size);
+        } catch (Allocator::AllocError &) {
+            // Bounded compaction step could be enough to make room without evicting live items
+            if (!compacted && _allocator->available() >= size && Fragmented()) {
+                compacted = true;
+                Compact();
+                continue;
+            }
+            if (_root->head == 0) {
+                return false;
+            }
+
+            Node *victim = ToNode(_root->head);
+            Remove(Link(victim->data(), victim->key_size, victim->hash));
+            _root->evictions++;
+        }
+    }
+
+    uint32_t handle = _allocator->compact(pointer.offset());
+    Node *node = static_cast<Node *>(pointer.get());
+    node->hash = hash;
+    node->key_size = key.size();
+    node->value_size = value.size();
+    std::memcpy(node->data(), key.data(), key.size());
+    std::memcpy(node->data() + key.size(), value.data(), value.size());
+
+    // Eviction might have changed the chain, so take the bucket again
+    uint32_t *buckets = static_cast<uint32_t *>(_allocator->get(_root->buckets).get());
+    uint32_t &bucket = buckets[hash & (_root->bucket_count - 1)];
+    node->chain = bucket;
+    bucket = handle;
+
+    node->prev = _root->tail;
+    node->next = 0;
+    if (_root->tail != 0) {
+        ToNode(_root->tail)->next = handle;
+    } else {
+        _root->head = handle;
+    }
+    _root->tail = handle;
+
+    _root->items++;
+    _root->bytes += key.size() + value.size();
+    return true;
+}
+
+// See SharedLRU.h
+void SharedLRU::Remove(uint32_t *slot) {
+    Allocator::Pointer pointer = _allocator->get(_allocator->expand(*slot));
+    Node *node = static_cast<Node *>(pointer.get());
+    *slot = node->chain;
+
+    if (node->prev != 0) {
+        ToNode(node->prev)->next = node->next;
+    } else {
+        _root->head = node->next;
+    }
+    if (node->next != 0) {
+        ToNode(node->next)->prev = node->prev;
+    } else {
+        _root->tail = node->prev;
+    }
+
+    _root->items--;
+    _root->bytes -= node->key_size + node->value_size;
+    _allocator->free(pointer);
+    ScheduleDefrag();
+}
+
+// See SharedLRU.h
+bool SharedLRU::Fragmented() const {
+    return _allocator->available() >= _size / kDefragPart && _allocator->fragmentation() >= kDefragRatio;
+}
+
+// See SharedLRU.h
+std::size_t SharedLRU::Compact() {
+    std::size_t moved = _allocator->defrag(kDefragStepBytes, kDefragStepTime);
+    _root = static_cast<Root *>(_allocator->get(_allocator->root()).get());
+    _root->defrag_steps++;
+    _root->defrag_bytes += moved;
+    return moved;
+}
+
+// See SharedLRU.h
+void SharedLRU::ScheduleDefrag() {
+    if (!_running || _defrag_scheduled || !Fragmented()) {
+        return;
+    }
+
+    _defrag_scheduled = _executor->Execute(&SharedLRU::OnDefrag, this);
+}
+
+// See SharedLRU.h
+void SharedLRU::OnDefrag() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_running && Fragmented() && Compact() != 0) {
+        lock.unlock();
+        lock.lock();
+    }
+    _defrag_scheduled = false;
+}
+
+// See SharedLRU.h
+void SharedLRU::MoveToTail(uint32_t handle) {
+    Node *node = ToNode(handle);
+    if (_root->tail == handle) {
+        return;
+    }
+
+    if (node->prev != 0) {
+        ToNode(node->prev)->next = node->next;
+    } else {
+        _root->head = node->next;
+    }
+    ToNode(node->next)->prev = node->prev;
+
+    node->prev = _root->tail;
+    node->next = 0;
+    ToNode(_root->tail)->next = handle;
+    _root->tail = handle;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,163 @@
+#ifndef AFINA_STORAGE_SHARED_LRU_H
+#define AFINA_STORAGE_SHARED_LRU_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Simple.h>
+#include <afina/concurrency/Executor.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU in shared memory
+ * Keeps the whole cache: items, hash index and LRU list, in the named POSIX shared memory segment
+ * managed by Allocator::Simple. All references inside of the segment are offsets, so restarted or
+ * upgraded server maps segment at any address and gets warm cache back without loading anything.
+ *
+ * Segment is reused only if the previous owner detached cleanly and the layout is the same, otherwise
+ * it is formatted from scratch. Single process owns the segment at a time: the next one waits in
+ * constructor until the previous one exits.
+ *
+ * Index is the hash table of fixed size, so Scan and DeletePrefix aren't supported. Fork isn't
+ * supported either as the child would see shared memory changing under it, so snapshots and log
+ * compaction fail with this storage. All operations are serialized by the global lock
+ *
+ * Once started, storage compacts segment in background whenever evictions leave free memory
+ * scattered, see Allocator::Simple::fragmentation. Compaction goes in steps bounded by time and
+ * bytes moved, the lock is released between steps so client operations don't see long pauses
+ */
+class SharedLRU : public Afina::Storage {
+public:
+    /**
+     * Opens or creates segment, throws std::runtime_error on failure
+     * @param name of the shared memory object, see shm_open
+     * @param size of the segment, changing it formats the segment
+     * @param huge_pages advise the kernel to back segment by transparent huge pages
+     * @param buddy round items up to powers of two, so that appends mostly grow them in place, see
+     *              Allocator::Simple::buddy
+     */
+    SharedLRU(const std::string &name, std::size_t size, bool huge_pages = false, bool buddy = false);
+    ~SharedLRU();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, grows the item by realloc, so data isn't copied unless
+    // item has to move
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface, reports dump of the segment allocator with shm_ prefix
+    void AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override;
+
+    /**
+     * True if cache content has been inherited from the previous owner of the segment
+     */
+    bool Attached() const { return _attached; }
+
+    /**
+     * Removes shared memory object, segment lives until the last owner unmaps it
+     */
+    static bool Remove(const std::string &name);
+
+private:
+    struct Root;
+    struct Node;
+
+    // Creates empty cache in the formatted segment
+    void Format();
+
+    // Items larger than the part of the segment are rejected, so that single item doesn't flush the
+    // whole cache
+    bool Fits(const std::string &key, const std::string &value) const;
+
+    Node *ToNode(uint32_t handle) const;
+
+    // Slot of the index or the chain which refers to the node with the given key, slot holds zero
+    // if there is no such node
+    uint32_t *Link(const char *key, uint32_t key_size, uint32_t hash);
+
+    // Creates node in the tail of the list evicting old ones if there is no memory
+    bool Insert(const std::string &key, const std::string &value, uint32_t hash);
+
+    // Unlinks node referred by the slot from the index and the list, releases memory
+    void Remove(uint32_t *slot);
+
+    // Moves node to the tail of the list, i.e mark it as recently used
+    void MoveToTail(uint32_t handle);
+
+    // True if free memory is large and scattered enough to be worth compaction
+    bool Fragmented() const;
+
+    // Takes single compaction step, returns number of bytes moved. Nodes could move, so addresses
+    // taken before are invalid after the call
+    std::size_t Compact();
+
+    // Enqueue compaction task if segment is fragmented and task isn't enqueued yet, must be called
+    // with _lock held
+    void ScheduleDefrag();
+
+    // Compaction task: takes steps until segment isn't fragmented, releasing lock between them
+    void OnDefrag();
+
+    std::string _name;
+
+    int _fd;
+
+    void *_data;
+
+    std::size_t _size;
+
+    bool _huge_pages;
+
+    std::unique_ptr<Allocator::Simple> _allocator;
+
+    Root *_root;
+
+    bool _attached;
+
+    // Global lock serializing all access to the storage
+    std::mutex _lock;
+
+    // Flag signals that background compaction is allowed
+    bool _running;
+
+    // True if compaction task is in the executor queue or running
+    bool _defrag_scheduled;
+
+    // Executor running compaction task
+    std::unique_ptr<Concurrency::Executor> _executor;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARED_LRU_H
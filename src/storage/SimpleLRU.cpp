@@ -1,22 +1,411 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "ArtIndex.h"
+#include "HashIndex.h"
+#include "MapIndex.h"
+
 namespace Afina {
 namespace Backend {
 
+// See ChunkedValue.h
+constexpr std::size_t ChunkedValue::kChunkSize;
+
+// Average size of key and value filter gets sized for
+static const std::size_t kFilterBytesPerItem = 64;
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(size_t max_size, IndexType index, bool filter)
+    : _max_size(max_size), _size(0), _low_watermark(max_size), _evictions_inline(0), _evictions_background(0),
+      _lru_tail(nullptr), _filter_negatives(0), _filter_false_positives(0) {
+    if (filter) {
+        _filter.reset(new CountingBloomFilter(std::max<std::size_t>(1024, max_size / kFilterBytesPerItem)));
+    }
+
+    switch (index) {
+    case IndexType::kMap:
+        _lru_index.reset(new MapIndex<lru_node>());
+        break;
+    case IndexType::kHash:
+        _lru_index.reset(new HashIndex<lru_node>());
+        break;
+    case IndexType::kArt:
+        _lru_index.reset(new ArtIndex<lru_node>());
+        break;
+    default:
+        throw std::runtime_error("Unknown index type");
+    }
+}
+
+// See SimpleLRU.h
+SimpleLRU::~SimpleLRU() {
+    _lru_index->Clear();
+
+    // Destroy list iteratively, otherwise chain of unique_ptr destructors overflows the stack
+    while (_lru_head) {
+        std::unique_ptr<lru_node> next = std::move(_lru_head->next);
+        _lru_head = std::move(next);
+    }
+}
+
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) { return false; }
+bool SimpleLRU::Put(const std::string &key, const std::string &value) {
+    return Put(key, KeyHash::Compute(key.data(), key.size()), value);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) { return false; }
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsent(key, KeyHash::Compute(key.data(), key.size()), value);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) { return false; }
+bool SimpleLRU::Set(const std::string &key, const std::string &value) {
+    return Set(key, KeyHash::Compute(key.data(), key.size()), value);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) { return false; }
+bool SimpleLRU::Delete(const std::string &key) {
+    lru_node *node = _lru_index->Find(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    Remove(*node);
+    return true;
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get(const std::string &key, std::string &value) { return false; }
+bool SimpleLRU::Get(const std::string &key, std::string &value) {
+    return Get(key, KeyHash::Compute(key.data(), key.size()), value);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) {
+    return GetChunks(key, KeyHash::Compute(key.data(), key.size()), chunks);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Append(const std::string &key, const std::string &data) {
+    return Append(key, KeyHash::Compute(key.data(), key.size()), data);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Put(const std::string &key, uint64_t hash, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    lru_node *node = _lru_index->Find(key, hash);
+    if (node != nullptr) {
+        Update(*node, value);
+    } else {
+        Insert(key, hash, value);
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) {
+    if (key.size() + value.size() > _max_size || _lru_index->Find(key, hash) != nullptr) {
+        return false;
+    }
+
+    Insert(key, hash, value);
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Set(const std::string &key, uint64_t hash, const std::string &value) {
+    lru_node *node = _lru_index->Find(key, hash);
+    if (node == nullptr || key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    Update(*node, value);
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Get(const std::string &key, uint64_t hash, std::string &value) {
+    return MayContain(key, hash) && Lookup(key, hash, value);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::GetChunks(const std::string &key, uint64_t hash,
+                          std::vector<std::shared_ptr<const std::string>> &chunks) {
+    return MayContain(key, hash) && LookupChunks(key, hash, chunks);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::MayContain(const std::string &key) const {
+    return !_filter || MayContain(key, KeyHash::Compute(key.data(), key.size()));
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::MayContain(const std::string &key, uint64_t hash) const {
+    if (_filter && !_filter->MayContain(hash)) {
+        _filter_negatives.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Append(const std::string &key, uint64_t hash, const std::string &data) {
+    lru_node *node = _lru_index->Find(key, hash);
+    if (node == nullptr || key.size() + node->value.Size() + data.size() > _max_size) {
+        return false;
+    }
+
+    // Node is the freshest one now, so it won't be evicted while making space for the new data
+    MoveToTail(*node);
+    Evict(data.size());
+
+    node->value.Append(data.data(), data.size());
+    _size += data.size();
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Lookup(const std::string &key, uint64_t hash, std::string &value) {
+    lru_node *node = Touch(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+
+    node->value.CopyTo(value);
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::LookupChunks(const std::string &key, uint64_t hash,
+                             std::vector<std::shared_ptr<const std::string>> &chunks) {
+    lru_node *node = Touch(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+
+    node->value.Share(chunks);
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Scan(const std::string &prefix, const std::string &after, std::size_t count,
+                     std::vector<std::string> &keys) {
+    if (count == 0) {
+        return _lru_index->Walk(prefix, after, [](lru_node *) { return false; });
+    }
+
+    return _lru_index->Walk(prefix, after, [&keys, &count](lru_node *node) {
+        keys.push_back(node->key);
+        return --count > 0;
+    });
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) {
+    deleted = 0;
+    if (count == 0) {
+        return _lru_index->Walk(prefix, "", [](lru_node *) { return false; });
+    }
+
+    // Index must not be modified during walk, so collect victims first
+    std::vector<lru_node *> victims;
+    bool ordered = _lru_index->Walk(prefix, "", [&victims, count](lru_node *node) {
+        victims.push_back(node);
+        return victims.size() < count;
+    });
+
+    for (lru_node *node : victims) {
+        Remove(*node);
+    }
+    deleted = victims.size();
+    return ordered;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Resize(std::size_t max_size) {
+    SetMaxSize(max_size);
+    Evict(0);
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::SetMaxSize(std::size_t max_size) {
+    double ratio = _max_size == 0 ? 1.0 : double(_low_watermark) / _max_size;
+    _max_size = max_size;
+    _low_watermark = static_cast<std::size_t>(max_size * ratio);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_lru_index->Size()));
+    stats.emplace_back("bytes", std::to_string(_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("low_watermark_bytes", std::to_string(_low_watermark));
+    stats.emplace_back("evictions", std::to_string(_evictions_inline + _evictions_background));
+    stats.emplace_back("evictions_inline", std::to_string(_evictions_inline));
+    stats.emplace_back("evictions_background", std::to_string(_evictions_background));
+    _lru_index->Stats(stats);
+
+    if (_filter) {
+        uint64_t negatives = _filter_negatives.load(std::memory_order_relaxed);
+        uint64_t false_positives = _filter_false_positives.load(std::memory_order_relaxed);
+
+        // Share of absent keys filter failed to detect
+        char rate[32];
+        std::snprintf(rate, sizeof(rate), "%.4f",
+                      (negatives + false_positives) ? double(false_positives) / (negatives + false_positives) : 0.0);
+
+        stats.emplace_back("filter_counters", std::to_string(_filter->Size()));
+        stats.emplace_back("filter_negatives", std::to_string(negatives));
+        stats.emplace_back("filter_false_positives", std::to_string(false_positives));
+        stats.emplace_back("filter_false_positive_rate", rate);
+    }
+}
+
+// See SimpleLRU.h
+pid_t SimpleLRU::Fork() { return fork(); }
+
+// See SimpleLRU.h
+bool SimpleLRU::Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+    std::string buffer;
+    for (lru_node *node = _lru_head.get(); node != nullptr; node = node->next.get()) {
+        visit(0, node->key, node->value.View(buffer));
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::MaintenancePending() const { return _size > _low_watermark || _lru_index->MaintenancePending(); }
+
+// See SimpleLRU.h
+bool SimpleLRU::Maintain(std::size_t steps, std::unique_ptr<lru_node> &evicted) {
+    _lru_index->Maintain(steps);
+
+    // Find end of chain to append evicted nodes to
+    std::unique_ptr<lru_node> *last = &evicted;
+    while (*last) {
+        last = &(*last)->next;
+    }
+
+    for (std::size_t i = 0; i < steps && _lru_head && _size > _low_watermark; i++) {
+        OnEvict(*_lru_head);
+        *last = Detach(*_lru_head);
+        last = &(*last)->next;
+        _evictions_background++;
+    }
+    return MaintenancePending();
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Insert(const std::string &key, uint64_t hash, const std::string &value) {
+    Evict(key.size() + value.size());
+
+    std::unique_ptr<lru_node> node(new lru_node{key, hash, ChunkedValue(value), _lru_tail, nullptr});
+    lru_node *raw = node.get();
+    if (_lru_tail != nullptr) {
+        _lru_tail->next = std::move(node);
+    } else {
+        _lru_head = std::move(node);
+    }
+
+    _lru_tail = raw;
+    _size += key.size() + value.size();
+    _lru_index->Insert(raw, hash);
+    if (_filter) {
+        _filter->Add(hash);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Update(lru_node &node, const std::string &value) {
+    MoveToTail(node);
+
+    // Node is the freshest one now, so it won't be evicted while making space for the new value
+    _size -= node.value.Size();
+    Evict(value.size());
+
+    node.value.Assign(value);
+    _size += value.size();
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::Touch(const std::string &key, uint64_t hash) {
+    lru_node *node = _lru_index->Find(key, hash);
+    if (node == nullptr) {
+        if (_filter) {
+            _filter_false_positives.fetch_add(1, std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
+    MoveToTail(*node);
+    return node;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::MoveToTail(lru_node &node) {
+    if (&node == _lru_tail) {
+        return;
+    }
+
+    // Detach node from its current position, it is not the tail so next is always present
+    std::unique_ptr<lru_node> self;
+    if (node.prev != nullptr) {
+        self = std::move(node.prev->next);
+        node.prev->next = std::move(node.next);
+        node.prev->next->prev = node.prev;
+    } else {
+        self = std::move(_lru_head);
+        _lru_head = std::move(node.next);
+        _lru_head->prev = nullptr;
+    }
+
+    node.prev = _lru_tail;
+    _lru_tail->next = std::move(self);
+    _lru_tail = &node;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Remove(lru_node &node) { Detach(node); }
+
+// See SimpleLRU.h
+std::unique_ptr<SimpleLRU::lru_node> SimpleLRU::Detach(lru_node &node) {
+    _lru_index->Erase(node.key, node.hash);
+    _size -= node.key.size() + node.value.Size();
+    if (_filter) {
+        _filter->Remove(node.hash);
+    }
+
+    if (node.next) {
+        node.next->prev = node.prev;
+    } else {
+        _lru_tail = node.prev;
+    }
+
+    // Owner of the node is either previous node or the list head
+    std::unique_ptr<lru_node> &owner = (node.prev != nullptr) ? node.prev->next : _lru_head;
+    std::unique_ptr<lru_node> self = std::move(owner);
+    owner = std::move(node.next);
+
+    node.prev = nullptr;
+    return self;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Evict(std::size_t need) {
+    while (_lru_head && _size + need > _max_size) {
+        OnEvict(*_lru_head);
+        Remove(*_lru_head);
+        _evictions_inline++;
+    }
+}
 
 } // namespace Backend
 } // namespace Afina
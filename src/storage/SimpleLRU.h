@@ -1,12 +1,20 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 
 #include <afina/Storage.h>
+#include <afina/allocator/Pooled.h>
+
+#include "ChunkedValue.h"
+#include "CountingBloomFilter.h"
+#include "Index.h"
+#include "KeyHash.h"
 
 namespace Afina {
 namespace Backend {
@@ -14,15 +22,15 @@ namespace Backend {
 /**
  * # Map based implementation
  * That is NOT thread safe implementaiton!!
+ *
+ * Methods taking the key alone compute its KeyHash and call the prehashed variants, so that
+ * subclasses override only those
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size) {}
+    SimpleLRU(size_t max_size = 1024, IndexType index = IndexType::kMap, bool filter = false);
 
-    ~SimpleLRU() {
-        _lru_index.clear();
-        _lru_head.reset(); // TODO: Here is stack overflow
-    }
+    ~SimpleLRU();
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -39,27 +47,175 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
-private:
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override;
+
+    // Implements Afina::Storage interface
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override;
+
+    // Implements Afina::Storage interface
+    bool Resize(std::size_t max_size) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override;
+
+    /**
+     * Returns false if key is definitely not in the storage. Once storage is created with filter
+     * enabled that is an approximate answer based on the Bloom filter, otherwise method always
+     * returns true.
+     *
+     * Method doesn't modify storage and could be called without any synchronization
+     */
+    bool MayContain(const std::string &key) const;
+
+    // Same as above for the key with known hash
+    bool MayContain(const std::string &key, uint64_t hash) const;
+
+protected:
     // LRU cache node
     using lru_node = struct lru_node {
         std::string key;
-        std::string value;
-        std::unique_ptr<lru_node> prev;
+        uint64_t hash;
+        ChunkedValue value;
+        lru_node *prev;
         std::unique_ptr<lru_node> next;
+
+        // Nodes come and go with every write, so they live in the mempool
+        static void *operator new(std::size_t size) { return Allocator::Pooled::Alloc(size); }
+        static void operator delete(void *p, std::size_t size) { Allocator::Pooled::Free(p, size); }
     };
 
+    /**
+     * Same as Get, but doesn't consult filter, see MayContain
+     */
+    bool Lookup(const std::string &key, uint64_t hash, std::string &value);
+
+    /**
+     * Same as GetChunks, but doesn't consult filter, see MayContain
+     */
+    bool LookupChunks(const std::string &key, uint64_t hash, std::vector<std::shared_ptr<const std::string>> &chunks);
+
+    /**
+     * Sets number of bytes storage tries to keep usage below by background eviction, see Maintain.
+     * Once usage reaches _max_size eviction happens inline on the operation which needs space
+     */
+    void SetLowWatermark(std::size_t low_watermark) { _low_watermark = low_watermark; }
+
+    /**
+     * Changes _max_size without eviction, low watermark keeps its ratio to _max_size. Storage may
+     * stay above the limit until the next Maintain or operation which needs space
+     */
+    void SetMaxSize(std::size_t max_size);
+
+    /**
+     * Returns true if there is deferred work for the Maintain, i.e index needs maintenance or usage
+     * is above low watermark
+     */
+    virtual bool MaintenancePending() const;
+
+    /**
+     * Performs deferred work of the storage internals spending not more than given number of steps.
+     * Returns true if there is more work to do. Could be called periodically by the owner of
+     * storage in order to offload work from the client operations.
+     *
+     * Nodes evicted to get usage below low watermark aren't destroyed but appended to the given
+     * chain, so that caller could release memory outside of critical section
+     */
+    virtual bool Maintain(std::size_t steps, std::unique_ptr<lru_node> &evicted);
+
+    /**
+     * Called for the least recently used node right before it gets evicted, either inline or by
+     * Maintain, so that subclass could keep evicted data somewhere else. Not called for the nodes
+     * removed by client operations
+     */
+    virtual void OnEvict(const lru_node &node) {}
+
+private:
+    // Finds node and marks it as recently used, counts filter false positive if there is no node
+    lru_node *Touch(const std::string &key, uint64_t hash);
+
+    // Creates new node in the tail of the list, node size must fit into cache
+    void Insert(const std::string &key, uint64_t hash, const std::string &value);
+
+    // Replace value of the existing node and mark it as recently used
+    void Update(lru_node &node, const std::string &value);
+
+    // Moves node to the tail of the list, i.e mark it as recently used
+    void MoveToTail(lru_node &node);
+
+    // Unlink node from the list and the index, destroy it
+    void Remove(lru_node &node);
+
+    // Unlink node from the list and the index, ownership goes to the caller
+    std::unique_ptr<lru_node> Detach(lru_node &node);
+
+    // Evicts least recently used nodes until there is enough space for the given number of bytes
+    void Evict(std::size_t need);
+
     // Maximum number of bytes could be stored in this cache.
     // i.e all (keys+values) must be not greater than the _max_size
     std::size_t _max_size;
 
+    // Number of bytes currently stored in the cache
+    std::size_t _size;
+
+    // Usage background eviction keeps the cache below, see SetLowWatermark
+    std::size_t _low_watermark;
+
+    // Number of nodes evicted inline by operations and from the background by Maintain
+    uint64_t _evictions_inline;
+    uint64_t _evictions_background;
+
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
     // List owns all nodes
     std::unique_ptr<lru_node> _lru_head;
 
+    // Most recently used element of the list above
+    lru_node *_lru_tail;
+
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
+    std::unique_ptr<Index<lru_node>> _lru_index;
+
+    // Approximate set of keys in the cache, allows to answer misses without index lookup. Optional
+    std::unique_ptr<CountingBloomFilter> _filter;
+
+    // Misses answered by the filter and misses filter failed to detect
+    mutable std::atomic<uint64_t> _filter_negatives;
+    std::atomic<uint64_t> _filter_false_positives;
 };
 
 } // namespace Backend
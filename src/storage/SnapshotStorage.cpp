@@ -0,0 +1,370 @@
+#include "SnapshotStorage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Marks the end of complete snapshot file
+const char kMagic[8] = {'A', 'F', 'I', 'N', 'A', 'S', 'N', '1'};
+
+// Size of the buffer used to write snapshot file
+const std::size_t kWriteBuffer = 1 << 20;
+
+// Entry of the parts table
+struct Part {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t items;
+};
+
+// Last bytes of the file
+struct Footer {
+    uint64_t table;
+    uint64_t parts;
+    char magic[8];
+};
+
+// Read only mapping of the whole file
+class Mapping {
+public:
+    Mapping(void *data, std::size_t size) : data(static_cast<const char *>(data)), size(size) {}
+    ~Mapping() { munmap(const_cast<char *>(data), size); }
+
+    const char *data;
+    const std::size_t size;
+};
+
+uint64_t Elapsed(std::chrono::steady_clock::time_point since) {
+    auto elapsed = std::chrono::steady_clock::now() - since;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+// Puts records of a single part into the storage, returns number of them
+uint64_t LoadPart(Afina::Storage &storage, const char *begin, const char *end) {
+    std::string key, value;
+    uint64_t items = 0;
+    while (begin < end) {
+        uint32_t sizes[2];
+        if (static_cast<std::size_t>(end - begin) < sizeof(sizes)) {
+            throw std::runtime_error("Snapshot record is truncated");
+        }
+        std::memcpy(sizes, begin, sizeof(sizes));
+        begin += sizeof(sizes);
+
+        if (static_cast<uint64_t>(end - begin) < uint64_t(sizes[0]) + sizes[1]) {
+            throw std::runtime_error("Snapshot record is truncated");
+        }
+        key.assign(begin, sizes[0]);
+        value.assign(begin + sizes[0], sizes[1]);
+        begin += sizes[0] + sizes[1];
+
+        // Items larger than the storage could be are skipped by the storage itself
+        storage.Put(key, value);
+        items++;
+    }
+    return items;
+}
+
+} // namespace
+
+// See SnapshotStorage.h
+SnapshotStorage::SnapshotStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path, std::size_t period)
+    : _storage(std::move(storage)), _path(path), _period(period), _running(false), _child(0), _snapshots(0),
+      _snapshots_failed(0), _last_fork_usec(0), _last_snapshot_usec(0), _last_snapshot_time(0), _loaded_items(0),
+      _load_usec(0) {}
+
+// See SnapshotStorage.h
+SnapshotStorage::~SnapshotStorage() { Stop(); }
+
+// See SnapshotStorage.h
+void SnapshotStorage::Start() {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_running) {
+        return;
+    }
+
+    _storage->Start();
+    _running = true;
+    if (_period > 0) {
+        _timer = std::thread(&SnapshotStorage::OnTimer, this);
+    }
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::Stop() {
+    std::unique_lock<std::mutex> lock(_lock);
+    bool running = _running;
+    _running = false;
+    _state_changed.notify_all();
+
+    lock.unlock();
+    if (_timer.joinable()) {
+        _timer.join();
+    }
+    lock.lock();
+
+    // Take the last snapshot, so that restart doesn't lose changes made after the periodic one
+    if (running && _period > 0) {
+        _state_changed.wait(lock, [this] { return _child == 0; });
+        Spawn();
+    }
+
+    _state_changed.wait(lock, [this] { return _child == 0; });
+    if (_waiter.joinable()) {
+        _waiter.join();
+    }
+
+    if (running) {
+        _storage->Stop();
+    }
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+
+    std::unique_lock<std::mutex> lock(_lock);
+    stats.emplace_back("snapshot_in_progress", (_child != 0) ? "1" : "0");
+    stats.emplace_back("snapshot_total", std::to_string(_snapshots));
+    stats.emplace_back("snapshot_failed", std::to_string(_snapshots_failed));
+    stats.emplace_back("snapshot_last_time", std::to_string(_last_snapshot_time));
+    stats.emplace_back("snapshot_last_usec", std::to_string(_last_snapshot_usec));
+    stats.emplace_back("snapshot_last_fork_usec", std::to_string(_last_fork_usec));
+    stats.emplace_back("snapshot_loaded_items", std::to_string(_loaded_items));
+    stats.emplace_back("snapshot_load_usec", std::to_string(_load_usec));
+}
+
+// See SnapshotStorage.h
+bool SnapshotStorage::Snapshot() {
+    std::unique_lock<std::mutex> lock(_lock);
+    return Spawn();
+}
+
+// See SnapshotStorage.h
+std::size_t SnapshotStorage::Load(std::size_t threads) {
+    auto started = std::chrono::steady_clock::now();
+    std::size_t items = Read(*_storage, _path, threads);
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _loaded_items = items;
+    _load_usec = Elapsed(started);
+    return items;
+}
+
+// See SnapshotStorage.h
+std::size_t SnapshotStorage::Read(Afina::Storage &storage, const std::string &path, std::size_t threads) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        throw std::runtime_error("Failed to open snapshot " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Failed to stat snapshot " + path + ": " + std::strerror(error));
+    }
+
+    std::size_t size = st.st_size;
+    if (size < sizeof(Footer)) {
+        close(fd);
+        throw std::runtime_error("Snapshot " + path + " is truncated");
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map snapshot " + path + ": " + std::strerror(error));
+    }
+
+    // Every part is read once front to back, let kernel read ahead aggressively
+    Mapping file(data, size);
+    madvise(data, size, MADV_SEQUENTIAL);
+    madvise(data, size, MADV_WILLNEED);
+
+    Footer footer;
+    std::memcpy(&footer, file.data + size - sizeof(Footer), sizeof(Footer));
+    if (std::memcmp(footer.magic, kMagic, sizeof(kMagic)) != 0 || footer.table > size - sizeof(Footer) ||
+        footer.parts > (size - sizeof(Footer) - footer.table) / sizeof(Part)) {
+        throw std::runtime_error("Snapshot " + path + " is broken");
+    }
+
+    std::vector<Part> parts(footer.parts);
+    if (!parts.empty()) {
+        std::memcpy(&parts[0], file.data + footer.table, parts.size() * sizeof(Part));
+    }
+    for (auto &part : parts) {
+        if (part.offset > footer.table || part.size > footer.table - part.offset) {
+            throw std::runtime_error("Snapshot " + path + " is broken");
+        }
+    }
+
+    // Parts are distributed between workers round robin, each of them keeps its own order
+    threads = std::max<std::size_t>(1, std::min(threads, parts.size()));
+    std::atomic<uint64_t> loaded(0);
+    std::vector<std::exception_ptr> errors(threads);
+    auto worker = [&](std::size_t id) {
+        try {
+            for (std::size_t i = id; i < parts.size(); i += threads) {
+                const char *begin = file.data + parts[i].offset;
+                if (LoadPart(storage, begin, begin + parts[i].size) != parts[i].items) {
+                    throw std::runtime_error("Snapshot " + path + " is broken");
+                }
+                loaded.fetch_add(parts[i].items, std::memory_order_relaxed);
+            }
+        } catch (...) {
+            errors[id] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return loaded.load();
+}
+
+// See SnapshotStorage.h
+bool SnapshotStorage::Write(Afina::Storage &storage, const std::string &path, const std::string &prefix) {
+    std::string tmp = path + ".tmp";
+    FILE *file = std::fopen(tmp.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::vector<char> buffer(kWriteBuffer);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    std::vector<Part> parts;
+    std::size_t current = 0;
+    uint64_t offset = 0;
+    bool ok = storage.Dump([&](std::size_t part, const std::string &key, const std::string &value) {
+        if (key.compare(0, prefix.size(), prefix) != 0) {
+            return;
+        }
+        if (parts.empty() || part != current) {
+            parts.push_back(Part{offset, 0, 0});
+            current = part;
+        }
+
+        uint32_t sizes[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+        std::fwrite(sizes, sizeof(sizes), 1, file);
+        std::fwrite(key.data(), 1, key.size(), file);
+        std::fwrite(value.data(), 1, value.size(), file);
+
+        uint64_t record = sizeof(sizes) + key.size() + value.size();
+        offset += record;
+        parts.back().size += record;
+        parts.back().items++;
+    });
+
+    Footer footer;
+    footer.table = offset;
+    footer.parts = parts.size();
+    std::memcpy(footer.magic, kMagic, sizeof(kMagic));
+    if (!parts.empty()) {
+        std::fwrite(parts.data(), sizeof(Part), parts.size(), file);
+    }
+    std::fwrite(&footer, sizeof(footer), 1, file);
+
+    ok = ok && std::fflush(file) == 0 && !std::ferror(file) && fsync(fileno(file)) == 0;
+    ok = (std::fclose(file) == 0) && ok;
+    if (ok && std::rename(tmp.c_str(), path.c_str()) == 0) {
+        return true;
+    }
+
+    unlink(tmp.c_str());
+    return false;
+}
+
+// See SnapshotStorage.h
+bool SnapshotStorage::Spawn() {
+    if (_child != 0) {
+        return false;
+    }
+
+    // Previous waiter has already left the critical section, so it is done
+    if (_waiter.joinable()) {
+        _waiter.join();
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    pid_t pid = _storage->Fork();
+    if (pid < 0) {
+        _snapshots_failed++;
+        return false;
+    }
+
+    if (pid == 0) {
+        // Child has only this thread, everything else is frozen at the state of fork, so
+        // nothing but the storage image must be touched here
+        _exit(Write(*_storage, _path) ? 0 : 1);
+    }
+
+    _last_fork_usec = Elapsed(started);
+    _child = pid;
+    _waiter = std::thread(&SnapshotStorage::Await, this, pid, started);
+    return true;
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::Await(pid_t child, std::chrono::steady_clock::time_point started) {
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(child, &status, 0);
+    } while (result < 0 && errno == EINTR);
+
+    std::unique_lock<std::mutex> lock(_lock);
+    if (result == child && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        _snapshots++;
+        _last_snapshot_time = std::time(nullptr);
+    } else {
+        _snapshots_failed++;
+    }
+
+    _last_snapshot_usec = Elapsed(started);
+    _child = 0;
+    _state_changed.notify_all();
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::OnTimer() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_state_changed.wait_for(lock, std::chrono::seconds(_period), [this] { return !_running; })) {
+        Spawn();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
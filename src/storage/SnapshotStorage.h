@@ -0,0 +1,204 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_STORAGE_H
+#define AFINA_STORAGE_SNAPSHOT_STORAGE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage snapshots
+ * Decorates another storage with ability to save its image into the file and load it back on
+ * start, so that restart doesn't begin with the empty cache.
+ *
+ * Snapshot is taken by the forked child: storage gets quiesced only for the fork itself, then child
+ * writes copy-on-write image of the storage while parent keeps serving clients. Snapshots are taken
+ * on demand, periodically if period is set and once more on Stop in that case.
+ *
+ * File consists of records of every storage part one after another, followed by the table of parts
+ * and the footer, so that parts could be loaded in parallel. Records of the part go from the least
+ * recently used, each is key size and value size as 32-bit numbers followed by key and value bytes.
+ * All numbers are in the native byte order, file isn't meant to be moved between machines.
+ */
+class SnapshotStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to decorate
+     * @param path of the snapshot file
+     * @param period between snapshots in seconds, 0 disables periodic snapshots
+     */
+    SnapshotStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path, std::size_t period = 0);
+    ~SnapshotStorage();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return _storage->Put(key, value); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return _storage->Set(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        return _storage->GetChunks(key, chunks);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override { return _storage->Append(key, data); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override {
+        return _storage->Put(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override {
+        return _storage->PutIfAbsent(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override {
+        return _storage->Set(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override {
+        return _storage->Get(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        return _storage->GetChunks(key, hash, chunks);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override {
+        return _storage->Append(key, hash, data);
+    }
+
+    // Implements Afina::Storage interface
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override {
+        return _storage->Scan(prefix, after, count, keys);
+    }
+
+    // Implements Afina::Storage interface
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override {
+        return _storage->DeletePrefix(prefix, count, deleted);
+    }
+
+    // Implements Afina::Storage interface
+    bool Resize(std::size_t max_size) override { return _storage->Resize(max_size); }
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    void AllocatorStats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        _storage->AllocatorStats(stats);
+    }
+
+    // Implements Afina::Storage interface
+    pid_t Fork() override { return _storage->Fork(); }
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override {
+        return _storage->Dump(visit);
+    }
+
+    // Implements Afina::Storage interface
+    bool Snapshot() override;
+
+    /**
+     * Loads snapshot file into the storage, parts of the file are loaded by the given number of
+     * threads in parallel. It is up to the caller to make sure storage could be accessed concurrently.
+     *
+     * Method returns number of loaded associations, missing file is the same as empty one. Throws
+     * std::runtime_error if file can't be read or is broken, storage may be partially loaded then
+     */
+    std::size_t Load(std::size_t threads);
+
+    /**
+     * Writes associations of the storage into the file, replacing it atomically. Storage must not
+     * be modified concurrently.
+     *
+     * Method returns false if storage can't be dumped or writing fails, file stays untouched then
+     *
+     * @param prefix only keys starting with it are written
+     */
+    static bool Write(Afina::Storage &storage, const std::string &path, const std::string &prefix = "");
+
+    /**
+     * Same as Load, but reads arbitrary file into the given storage
+     */
+    static std::size_t Read(Afina::Storage &storage, const std::string &path, std::size_t threads);
+
+private:
+    // Forks child writing the snapshot, must be called with _lock held
+    bool Spawn();
+
+    // Body of the thread waiting for the child to complete
+    void Await(pid_t child, std::chrono::steady_clock::time_point started);
+
+    // Body of the thread taking periodic snapshots
+    void OnTimer();
+
+    std::shared_ptr<Afina::Storage> _storage;
+
+    std::string _path;
+
+    std::size_t _period;
+
+    // Guards all fields below
+    std::mutex _lock;
+
+    // Signals about stop and about child completion
+    std::condition_variable _state_changed;
+
+    bool _running;
+
+    // Pid of the child writing snapshot, 0 if there is no one
+    pid_t _child;
+
+    std::thread _timer;
+
+    std::thread _waiter;
+
+    // Counters reported in stats
+    uint64_t _snapshots;
+    uint64_t _snapshots_failed;
+    uint64_t _last_fork_usec;
+    uint64_t _last_snapshot_usec;
+    int64_t _last_snapshot_time;
+    uint64_t _loaded_items;
+    uint64_t _load_usec;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_STORAGE_H
@@ -2,9 +2,12 @@
 #define AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 
+#include <afina/concurrency/Executor.h>
+
 #include "SimpleLRU.h"
 
 namespace Afina {
@@ -12,46 +15,211 @@ namespace Backend {
 
 /**
  * # SimpleLRU thread safe version
+ * All operations are serialized by the global lock. Once started, storage runs background
+ * maintenance task that takes deferred work off the client operations:
+ * - index resize, see HashIndex
+ * - batch eviction that keeps usage below low watermark, so that write operations need to evict
+ *   inline only once usage hits _max_size
  *
- *
+ * If filter is enabled then Get checks it before taking the lock, see SimpleLRU::MayContain
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
-    ~ThreadSafeSimplLRU() {}
+    ThreadSafeSimplLRU(size_t max_size = 1024, IndexType index = IndexType::kMap, bool filter = false)
+        : SimpleLRU(max_size, index, filter), _running(false), _maintenance_scheduled(false) {
+        SetLowWatermark(max_size / 100 * kLowWatermarkPercent);
+    }
+    ~ThreadSafeSimplLRU() { Stop(); }
+
+    // see Storage.h
+    void Start() override {
+        std::unique_lock<std::mutex> lock(_lock);
+        if (_running) {
+            return;
+        }
+
+        _running = true;
+        _executor.reset(new Concurrency::Executor("storage", 1));
+    }
+
+    // see Storage.h
+    void Stop() override {
+        std::unique_ptr<Concurrency::Executor> executor;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _running = false;
+            executor = std::move(_executor);
+        }
+
+        if (executor) {
+            executor->Stop(true);
+        }
+    }
+
+    using SimpleLRU::Put;
+    using SimpleLRU::PutIfAbsent;
+    using SimpleLRU::Set;
+    using SimpleLRU::Get;
+    using SimpleLRU::GetChunks;
+    using SimpleLRU::Append;
 
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
-        return SimpleLRU::Put(key, value);
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        bool result = SimpleLRU::Put(key, hash, value);
+        ScheduleMaintenance();
+        return result;
     }
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
-        return SimpleLRU::PutIfAbsent(key, value);
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        bool result = SimpleLRU::PutIfAbsent(key, hash, value);
+        ScheduleMaintenance();
+        return result;
     }
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
-        return SimpleLRU::Set(key, value);
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        bool result = SimpleLRU::Set(key, hash, value);
+        ScheduleMaintenance();
+        return result;
     }
 
     // see SimpleLRU.h
     bool Delete(const std::string &key) override {
-        // TODO: sinchronization
-        return SimpleLRU::Delete(key);
+        std::unique_lock<std::mutex> lock(_lock);
+        bool result = SimpleLRU::Delete(key);
+        ScheduleMaintenance();
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override {
+        // Filter answers most of misses without taking the lock
+        if (!SimpleLRU::MayContain(key, hash)) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        return SimpleLRU::Lookup(key, hash, value);
+    }
+
+    // see SimpleLRU.h
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override {
+        if (!SimpleLRU::MayContain(key, hash)) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        return SimpleLRU::LookupChunks(key, hash, chunks);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        bool result = SimpleLRU::Append(key, hash, data);
+        ScheduleMaintenance();
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        return SimpleLRU::Scan(prefix, after, count, keys);
     }
 
     // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) override {
-        // TODO: sinchronization
-        return SimpleLRU::Get(key, value);
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        bool result = SimpleLRU::DeletePrefix(prefix, count, deleted);
+        ScheduleMaintenance();
+        return result;
     }
 
+    // see SimpleLRU.h, shrink evicts in background once storage is started
+    bool Resize(std::size_t max_size) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        if (!_running) {
+            return SimpleLRU::Resize(max_size);
+        }
+
+        SetMaxSize(max_size);
+        ScheduleMaintenance();
+        return true;
+    }
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        SimpleLRU::Stats(stats);
+    }
+
+    // see SimpleLRU.h
+    pid_t Fork() override {
+        std::unique_lock<std::mutex> lock = Quiesce();
+        return SimpleLRU::Fork();
+    }
+
+    // see SimpleLRU.h
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        return SimpleLRU::Dump(visit);
+    }
+
+    /**
+     * Blocks all operations on the storage until returned lock is released
+     */
+    std::unique_lock<std::mutex> Quiesce() { return std::unique_lock<std::mutex>(_lock); }
+
+protected:
+    // Enqueue maintenance task if there is something to do and it isn't enqueued yet, must be
+    // called with _lock held
+    void ScheduleMaintenance() {
+        if (!_running || _maintenance_scheduled || !MaintenancePending()) {
+            return;
+        }
+
+        _maintenance_scheduled = _executor->Execute(&ThreadSafeSimplLRU::OnMaintenance, this);
+    }
+
+    // Global lock serializing all access to the storage
+    std::mutex _lock;
+
 private:
-    // TODO: sinchronization primitives
+    // Percent of _max_size background eviction keeps usage below
+    static constexpr std::size_t kLowWatermarkPercent = 90;
+
+    // How many steps of deferred work maintenance task performs under the lock at once
+    static constexpr std::size_t kMaintenanceSteps = 64;
+
+    // Maintenance task: performs deferred storage work in small portions, so that lock is never held
+    // for long and client operations could interleave. Evicted nodes are released out of the lock
+    void OnMaintenance() {
+        std::unique_lock<std::mutex> lock(_lock);
+        bool pending = true;
+        while (_running && pending) {
+            std::unique_ptr<lru_node> evicted;
+            pending = Maintain(kMaintenanceSteps, evicted);
+
+            lock.unlock();
+            evicted.reset();
+            lock.lock();
+        }
+        _maintenance_scheduled = false;
+    }
+
+    // Flag signals that background maintenance is allowed
+    bool _running;
+
+    // True if maintenance task is in the executor queue or running
+    bool _maintenance_scheduled;
+
+    // Executor running maintenance task
+    std::unique_ptr<Concurrency::Executor> _executor;
 };
 
 } // namespace Backend
@@ -0,0 +1,300 @@
+#include "TieredLRU.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See TieredLRU.h
+TieredLRU::TieredLRU(size_t max_size, IndexType index, const std::string &dir, size_t max_file_size,
+                     size_t segment_size)
+    : ThreadSafeSimplLRU(max_size, index), _segments(dir, segment_size), _max_file_size(max_file_size),
+      _compacting(false), _victim(0), _cursor(0), _demotions(0), _promotions(0), _dropped(0), _compactions(0) {}
+
+// See TieredLRU.h
+bool TieredLRU::Put(const std::string &key, uint64_t hash, const std::string &value) {
+    std::unique_lock<std::mutex> lock(_lock);
+    bool result = SimpleLRU::Put(key, hash, value);
+    if (result) {
+        Demoted(key, true);
+    }
+    ScheduleMaintenance();
+    return result;
+}
+
+// See TieredLRU.h
+bool TieredLRU::PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (Demoted(key, false)) {
+        return false;
+    }
+
+    bool result = SimpleLRU::PutIfAbsent(key, hash, value);
+    ScheduleMaintenance();
+    return result;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Set(const std::string &key, uint64_t hash, const std::string &value) {
+    std::unique_lock<std::mutex> lock(_lock);
+    bool result = SimpleLRU::Set(key, hash, value);
+    if (!result && Demoted(key, false)) {
+        // Item goes back to memory with the new value, old record becomes garbage
+        result = SimpleLRU::Put(key, hash, value);
+        if (result) {
+            Demoted(key, true);
+        }
+    }
+    ScheduleMaintenance();
+    return result;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Delete(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_lock);
+    bool result = SimpleLRU::Delete(key) || Demoted(key, true);
+    ScheduleMaintenance();
+    return result;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Get(const std::string &key, uint64_t hash, std::string &value) {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (SimpleLRU::Lookup(key, hash, value)) {
+        return true;
+    }
+
+    bool result = Promote(key, hash, value);
+    ScheduleMaintenance();
+    return result;
+}
+
+// See TieredLRU.h
+bool TieredLRU::GetChunks(const std::string &key, uint64_t hash,
+                          std::vector<std::shared_ptr<const std::string>> &chunks) {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (SimpleLRU::LookupChunks(key, hash, chunks)) {
+        return true;
+    }
+
+    std::string value;
+    if (!Promote(key, hash, value)) {
+        return false;
+    }
+    ScheduleMaintenance();
+    if (!SimpleLRU::LookupChunks(key, hash, chunks)) {
+        chunks.emplace_back(new std::string(std::move(value)));
+    }
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Append(const std::string &key, uint64_t hash, const std::string &data) {
+    std::unique_lock<std::mutex> lock(_lock);
+    std::string value;
+    bool result =
+        SimpleLRU::Append(key, hash, data) || (Promote(key, hash, value) && SimpleLRU::Append(key, hash, data));
+    ScheduleMaintenance();
+    return result;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Scan(const std::string &prefix, const std::string &after, std::size_t count,
+                     std::vector<std::string> &keys) {
+    std::unique_lock<std::mutex> lock(_lock);
+    std::vector<std::string> merged;
+    if (!SimpleLRU::Scan(prefix, after, count, merged)) {
+        return false;
+    }
+
+    auto it = _demoted.lower_bound(std::max(after, prefix));
+    for (std::size_t i = 0; i < count && it != _demoted.end(); ++it) {
+        if (it->first == after) {
+            continue;
+        }
+        if (it->first.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        merged.push_back(it->first);
+        i++;
+    }
+
+    std::sort(merged.begin(), merged.end());
+    if (merged.size() > count) {
+        merged.resize(count);
+    }
+    keys.insert(keys.end(), merged.begin(), merged.end());
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!SimpleLRU::DeletePrefix(prefix, count, deleted)) {
+        return false;
+    }
+
+    auto it = _demoted.lower_bound(prefix);
+    while (deleted < count && it != _demoted.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        _segments.Release(it->second);
+        it = _demoted.erase(it);
+        deleted++;
+    }
+
+    ScheduleMaintenance();
+    return true;
+}
+
+// See TieredLRU.h
+void TieredLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::unique_lock<std::mutex> lock(_lock);
+    SimpleLRU::Stats(stats);
+    stats.emplace_back("tier_items", std::to_string(_demoted.size()));
+    stats.emplace_back("tier_live_bytes", std::to_string(_segments.Live()));
+    stats.emplace_back("tier_file_bytes", std::to_string(_segments.Size()));
+    stats.emplace_back("tier_segments", std::to_string(_segments.Segments()));
+    stats.emplace_back("tier_demotions", std::to_string(_demotions));
+    stats.emplace_back("tier_promotions", std::to_string(_promotions));
+    stats.emplace_back("tier_dropped", std::to_string(_dropped));
+    stats.emplace_back("tier_compactions", std::to_string(_compactions));
+}
+
+// See TieredLRU.h
+bool TieredLRU::Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) {
+    std::unique_lock<std::mutex> lock(_lock);
+
+    // Segments are filled in order of eviction, so going through them keeps items order
+    std::string key, value;
+    for (uint32_t segment : _segments.List()) {
+        uint32_t cursor = 0;
+        SegmentManager::Location location;
+        while (_segments.Next(segment, cursor, key, location)) {
+            auto it = _demoted.find(key);
+            if (it != _demoted.end() && it->second == location) {
+                _segments.Read(location, value);
+                visit(0, key, value);
+            }
+        }
+    }
+
+    return SimpleLRU::Dump(visit);
+}
+
+// See TieredLRU.h
+bool TieredLRU::MaintenancePending() const {
+    uint32_t victim;
+    return SimpleLRU::MaintenancePending() || _compacting || _segments.Victim(victim);
+}
+
+// See TieredLRU.h
+bool TieredLRU::Maintain(std::size_t steps, std::unique_ptr<lru_node> &evicted) {
+    SimpleLRU::Maintain(steps, evicted);
+
+    if (!_compacting && _segments.Victim(_victim)) {
+        _compacting = true;
+        _cursor = 0;
+    }
+
+    // Move live records of the victim to the end of the log, then drop it
+    std::string key, value;
+    for (std::size_t i = 0; i < steps && _compacting; i++) {
+        SegmentManager::Location location;
+        if (!_segments.Next(_victim, _cursor, key, location)) {
+            _segments.Drop(_victim);
+            _compacting = false;
+            _compactions++;
+            break;
+        }
+
+        auto it = _demoted.find(key);
+        if (it == _demoted.end() || !(it->second == location)) {
+            continue;
+        }
+
+        _segments.Read(location, value);
+        _segments.Release(location);
+        if (!_segments.Append(key, value, it->second)) {
+            _demoted.erase(it);
+            _dropped++;
+        }
+    }
+
+    return MaintenancePending();
+}
+
+// See TieredLRU.h
+void TieredLRU::OnEvict(const lru_node &node) {
+    SegmentManager::Location location;
+    std::string buffer;
+    if (!_segments.Append(node.key, node.value.View(buffer), location)) {
+        _dropped++;
+        return;
+    }
+
+    _demoted[node.key] = location;
+    _demotions++;
+    Trim();
+}
+
+// See TieredLRU.h
+bool TieredLRU::Demoted(const std::string &key, bool erase) {
+    auto it = _demoted.find(key);
+    if (it == _demoted.end()) {
+        return false;
+    }
+
+    if (erase) {
+        _segments.Release(it->second);
+        _demoted.erase(it);
+    }
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Promote(const std::string &key, uint64_t hash, std::string &value) {
+    auto it = _demoted.find(key);
+    if (it == _demoted.end()) {
+        return false;
+    }
+
+    // Value which doesn't fit into memory anymore, e.g after Resize, is served from the files
+    SegmentManager::Location location = it->second;
+    _segments.Read(location, value);
+    if (!SimpleLRU::Put(key, hash, value)) {
+        return true;
+    }
+
+    // Item went back to memory, that may have pushed other items out to the files and dropped segments
+    it = _demoted.find(key);
+    if (it != _demoted.end() && it->second == location) {
+        _segments.Release(location);
+        _demoted.erase(it);
+    }
+    _promotions++;
+    return true;
+}
+
+// See TieredLRU.h
+void TieredLRU::Trim() {
+    uint32_t oldest;
+    while (_segments.Size() > _max_file_size && _segments.Oldest(oldest)) {
+        uint32_t cursor = 0;
+        std::string key;
+        SegmentManager::Location location;
+        while (_segments.Next(oldest, cursor, key, location)) {
+            auto it = _demoted.find(key);
+            if (it != _demoted.end() && it->second == location) {
+                _demoted.erase(it);
+                _dropped++;
+            }
+        }
+
+        if (_compacting && _victim == oldest) {
+            _compacting = false;
+        }
+        _segments.Drop(oldest);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,129 @@
+#ifndef AFINA_STORAGE_TIERED_LRU_H
+#define AFINA_STORAGE_TIERED_LRU_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "SegmentManager.h"
+#include "ThreadSafeSimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Two tier LRU
+ * Keeps hot items in memory as ThreadSafeSimplLRU does, but items evicted from memory aren't lost:
+ * their values go to the log structured files, see SegmentManager, while memory keeps only key and
+ * the small pointer to the record. Hit of such item reads value back and promotes item to memory.
+ *
+ * Once files grow above the limit the oldest segment gets dropped with all of its items. Background
+ * maintenance compacts segments which became mostly garbage because of promoted, overwritten and
+ * removed items.
+ *
+ * Value is read from the file under the storage lock, so a hit of the item which page cache has
+ * already dropped waits for disk and delays other clients. Item which doesn't fit into memory anymore
+ * stays in files and is read from there on every hit.
+ *
+ * Index of items in files is the ordered map with a copy of every key, its memory isn't counted against
+ * any limit and grows with the number of items in files, i.e with the files limit over the average item
+ * size
+ */
+class TieredLRU : public ThreadSafeSimplLRU {
+public:
+    /**
+     * @param max_size memory limit, see SimpleLRU
+     * @param index type of the memory index
+     * @param dir directory to create files in
+     * @param max_file_size limit of files size
+     * @param segment_size size of the single file
+     */
+    TieredLRU(size_t max_size, IndexType index, const std::string &dir, size_t max_file_size,
+              size_t segment_size = 64 << 20);
+    ~TieredLRU() { Stop(); }
+
+    using ThreadSafeSimplLRU::Put;
+    using ThreadSafeSimplLRU::PutIfAbsent;
+    using ThreadSafeSimplLRU::Set;
+    using ThreadSafeSimplLRU::Get;
+    using ThreadSafeSimplLRU::GetChunks;
+    using ThreadSafeSimplLRU::Append;
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, uint64_t hash, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key) override;
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, uint64_t hash, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool GetChunks(const std::string &key, uint64_t hash,
+                   std::vector<std::shared_ptr<const std::string>> &chunks) override;
+
+    // see SimpleLRU.h, item in files gets promoted first
+    bool Append(const std::string &key, uint64_t hash, const std::string &data) override;
+
+    // see SimpleLRU.h
+    bool Scan(const std::string &prefix, const std::string &after, std::size_t count,
+              std::vector<std::string> &keys) override;
+
+    // see SimpleLRU.h
+    bool DeletePrefix(const std::string &prefix, std::size_t count, std::size_t &deleted) override;
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // see SimpleLRU.h, items in files go first as they are older than ones in memory
+    bool Dump(const std::function<void(std::size_t, const std::string &, const std::string &)> &visit) override;
+
+protected:
+    // see SimpleLRU.h, adds compaction of segments
+    bool MaintenancePending() const override;
+
+    // see SimpleLRU.h
+    bool Maintain(std::size_t steps, std::unique_ptr<lru_node> &evicted) override;
+
+    // see SimpleLRU.h, moves item to files
+    void OnEvict(const lru_node &node) override;
+
+private:
+    // Returns true if item is in files, removes it from there if erase is set
+    bool Demoted(const std::string &key, bool erase);
+
+    // Moves item from files back to memory if it fits there, returns false if there is no such item in files
+    bool Promote(const std::string &key, uint64_t hash, std::string &value);
+
+    // Drops the oldest segments while files are above the limit
+    void Trim();
+
+    // Keys of items in files and location of their records
+    std::map<std::string, SegmentManager::Location> _demoted;
+
+    SegmentManager _segments;
+
+    std::size_t _max_file_size;
+
+    // Segment being compacted and position of the next record to move
+    bool _compacting;
+    uint32_t _victim;
+    uint32_t _cursor;
+
+    // Counters reported in stats
+    uint64_t _demotions;
+    uint64_t _promotions;
+    uint64_t _dropped;
+    uint64_t _compactions;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIERED_LRU_H
@@ -0,0 +1,527 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Pooled.h>
+#include <afina/allocator/Simple.h>
+
+namespace {
+
+// Step of the trace: allocation of size bytes into the slot or, if size is zero, release of the slot.
+// Slots are shared by all threads, so that one thread could free what the other one allocated
+struct Op {
+    uint32_t slot;
+    uint32_t size;
+};
+
+struct Trace {
+    std::string name;
+
+    // Operations of each thread
+    std::vector<std::vector<Op>> threads;
+
+    std::size_t slots;
+};
+
+// Allocator under test. Fragmentation is the part of memory held by the allocator which isn't given
+// to the live objects, counting both free space and headers
+class Subject {
+public:
+    virtual ~Subject() {}
+
+    virtual void *Alloc(std::size_t size) = 0;
+
+    virtual void Free(void *p, std::size_t size) = 0;
+
+    // Bytes allocator holds
+    virtual std::size_t Footprint() = 0;
+};
+
+// Glibc malloc, footprint is what mallinfo reports for all arenas and mmap'ed chunks
+class Malloc : public Subject {
+public:
+    void *Alloc(std::size_t size) override { return std::malloc(size); }
+
+    void Free(void *p, std::size_t) override { std::free(p); }
+
+    std::size_t Footprint() override {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+        struct mallinfo2 info = mallinfo2();
+#else
+        struct mallinfo info = mallinfo();
+#endif
+        return info.arena + info.hblkhd;
+    }
+};
+
+// Simple over the anonymous mapping, serialized by the lock as Simple isn't thread safe. Footprint is
+// everything but the free space in the largest free block, which is the untouched rest of the area
+class SimpleArea : public Subject {
+public:
+    SimpleArea(std::size_t size) : _size(size) {
+        _area = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (_area == MAP_FAILED) {
+            throw std::runtime_error("Failed to map area for Simple");
+        }
+        _simple.reset(new Afina::Allocator::Simple(_area, size));
+    }
+
+    ~SimpleArea() {
+        _simple.reset();
+        munmap(_area, _size);
+    }
+
+    void *Alloc(std::size_t size) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        try {
+            return _simple->alloc(size).get();
+        } catch (Afina::Allocator::AllocError &) {
+            return nullptr;
+        }
+    }
+
+    void Free(void *p, std::size_t) override {
+        std::unique_lock<std::mutex> lock(_lock);
+        Afina::Allocator::Pointer pointer = _simple->at(p);
+        _simple->free(pointer);
+    }
+
+    std::size_t Footprint() override {
+        std::unique_lock<std::mutex> lock(_lock);
+        double available = _simple->available();
+        return _simple->used() + std::size_t(available * _simple->fragmentation());
+    }
+
+private:
+    std::size_t _size;
+    void *_area;
+    std::unique_ptr<Afina::Allocator::Simple> _simple;
+    std::mutex _lock;
+};
+
+// Slab allocators behind Pooled with thread caches. Objects above Pooled::kMaxSize go to the heap,
+// those are counted as they are
+class Pools : public Subject {
+public:
+    Pools() : _large(0) {}
+
+    void *Alloc(std::size_t size) override {
+        if (size > Afina::Allocator::Pooled::kMaxSize) {
+            _large.fetch_add(size, std::memory_order_relaxed);
+        }
+        return Afina::Allocator::Pooled::Alloc(size);
+    }
+
+    void Free(void *p, std::size_t size) override {
+        if (size > Afina::Allocator::Pooled::kMaxSize) {
+            _large.fetch_sub(size, std::memory_order_relaxed);
+        }
+        Afina::Allocator::Pooled::Free(p, size);
+    }
+
+    std::size_t Footprint() override {
+        return Afina::Allocator::Pooled::Size() + _large.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::size_t> _large;
+};
+
+std::unique_ptr<Subject> Create(const std::string &name, std::size_t area) {
+    if (name == "malloc") {
+        return std::unique_ptr<Subject>(new Malloc());
+    } else if (name == "simple") {
+        return std::unique_ptr<Subject>(new SimpleArea(area));
+    } else if (name == "pooled") {
+        return std::unique_ptr<Subject>(new Pools());
+    }
+    throw std::runtime_error("Unknown allocator " + name);
+}
+
+// Size distributions of the synthetic traces
+const uint32_t kMinSize = 16;
+const uint32_t kUniformMax = 512;
+const uint32_t kZipfClasses = 256;
+
+class Sizes {
+public:
+    Sizes(const std::string &kind, uint64_t seed) : _kind(kind), _random(seed), _zipf(kZipfClasses) {
+        // Class k of kMinSize * k bytes has probability proportional to 1/k
+        double sum = 0;
+        for (uint32_t k = 1; k <= kZipfClasses; k++) {
+            sum += 1.0 / k;
+            _zipf[k - 1] = sum;
+        }
+        for (double &p : _zipf) {
+            p /= sum;
+        }
+    }
+
+    // Size of the next allocation, phase shifts the churn distribution
+    uint32_t Next(std::size_t phase) {
+        if (_kind == "zipf") {
+            double p = std::uniform_real_distribution<double>(0, 1)(_random);
+            return kMinSize * uint32_t(std::lower_bound(_zipf.begin(), _zipf.end(), p) - _zipf.begin() + 1);
+        } else if (_kind == "churn") {
+            uint32_t low = kMinSize << (phase % 6);
+            return std::uniform_int_distribution<uint32_t>(low, 2 * low)(_random);
+        }
+        return std::uniform_int_distribution<uint32_t>(kMinSize, kUniformMax)(_random);
+    }
+
+    std::mt19937_64 &Random() { return _random; }
+
+private:
+    std::string _kind;
+    std::mt19937_64 _random;
+    std::vector<double> _zipf;
+};
+
+/**
+ * Synthetic traces, each thread works with live slots of its own:
+ * - uniform, zipf: random slot gets allocated if empty and freed otherwise, sizes are uniform or zipf
+ * - churn: random slot gets freed and allocated again, size range doubles every eighth of the trace
+ *   and goes back after six phases, so memory freed by one phase is reused by objects of the other size
+ * - handoff: threads are producer/consumer pairs, producer allocates objects through the ring of live
+ *   slots and consumer frees them in the same order, so memory goes back from the other thread
+ */
+Trace Generate(const std::string &kind, std::size_t threads, std::size_t ops, std::size_t live) {
+    Trace trace;
+    trace.name = kind;
+    trace.slots = threads * live;
+    trace.threads.resize(threads);
+
+    if (kind == "handoff") {
+        for (std::size_t pair = 0; pair + 1 < threads; pair += 2) {
+            Sizes sizes(kind, pair);
+            for (std::size_t i = 0; i < ops; i++) {
+                uint32_t slot = uint32_t(pair * live + i % live);
+                trace.threads[pair].push_back(Op{slot, sizes.Next(0)});
+                trace.threads[pair + 1].push_back(Op{slot, 0});
+            }
+        }
+        return trace;
+    }
+
+    if (kind != "uniform" && kind != "zipf" && kind != "churn") {
+        throw std::runtime_error("Unknown trace " + kind);
+    }
+    for (std::size_t t = 0; t < threads; t++) {
+        Sizes sizes(kind, t);
+        std::vector<bool> full(live);
+        std::vector<Op> &out = trace.threads[t];
+        while (out.size() < ops) {
+            std::size_t index = std::uniform_int_distribution<std::size_t>(0, live - 1)(sizes.Random());
+            uint32_t slot = uint32_t(t * live + index);
+            if (full[index]) {
+                out.push_back(Op{slot, 0});
+            }
+            if (!full[index] || kind == "churn") {
+                out.push_back(Op{slot, sizes.Next(out.size() * 8 / ops)});
+            }
+            full[index] = !full[index] || kind == "churn";
+        }
+    }
+    return trace;
+}
+
+/**
+ * Recorded trace is the text file, one operation per line: "<thread> a <slot> <size>" allocates and
+ * "<thread> f <slot>" frees. Lines starting with # are skipped
+ */
+Trace Load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open trace " + path);
+    }
+
+    Trace trace;
+    trace.name = "recorded";
+    trace.slots = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::size_t thread;
+        char op;
+        Op step{0, 0};
+        if (!(fields >> thread >> op >> step.slot) || (op == 'a' && !(fields >> step.size)) ||
+            (op != 'a' && op != 'f') || (op == 'a' && step.size == 0)) {
+            throw std::runtime_error("Bad trace line: " + line);
+        }
+
+        if (thread >= trace.threads.size()) {
+            trace.threads.resize(thread + 1);
+        }
+        trace.threads[thread].push_back(step);
+        trace.slots = std::max<std::size_t>(trace.slots, step.slot + 1);
+    }
+    return trace;
+}
+
+void Save(const Trace &trace, const std::string &path) {
+    std::ofstream out(path);
+    out << "# " << trace.name << " trace: <thread> a <slot> <size> | <thread> f <slot>\n";
+    for (std::size_t t = 0; t < trace.threads.size(); t++) {
+        for (const Op &op : trace.threads[t]) {
+            if (op.size != 0) {
+                out << t << " a " << op.slot << " " << op.size << "\n";
+            } else {
+                out << t << " f " << op.slot << "\n";
+            }
+        }
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write trace " + path);
+    }
+}
+
+// Field of /proc/self/status in kilobytes
+std::size_t Status(const char *field) {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, std::strlen(field), field) == 0) {
+            return std::strtoull(line.c_str() + std::strlen(field) + 1, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+struct Result {
+    double seconds;
+    std::size_t ops;
+    std::size_t failures;
+    std::vector<double> fragmentation;
+};
+
+/**
+ * Replays trace by its threads at once. Thread waits while the slot it allocates into is still taken
+ * or the slot it frees is still empty, that only happens with slots shared by threads
+ */
+Result Replay(const Trace &trace, Subject &subject, std::size_t samples) {
+    std::unique_ptr<std::atomic<void *>[]> pointers(new std::atomic<void *>[trace.slots]);
+    std::unique_ptr<uint32_t[]> sizes(new uint32_t[trace.slots]);
+    for (std::size_t i = 0; i < trace.slots; i++) {
+        pointers[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Failed allocations leave the slot with the marker, so that the free of it is skipped
+    static char failed;
+    std::atomic<std::size_t> live(0), failures(0), ready(0);
+
+    // Memory subject holds before the trace, such as the arrays above for malloc
+    std::size_t baseline = subject.Footprint();
+    Result result;
+    result.ops = 0;
+
+    auto run = [&](std::size_t t) {
+        const std::vector<Op> &ops = trace.threads[t];
+        std::size_t period = samples != 0 ? std::max<std::size_t>(1, ops.size() / samples) : 0;
+        ready++;
+        while (ready.load() < trace.threads.size()) {
+            std::this_thread::yield();
+        }
+
+        for (std::size_t i = 0; i < ops.size(); i++) {
+            const Op &op = ops[i];
+            std::atomic<void *> &slot = pointers[op.slot];
+            if (op.size != 0) {
+                while (slot.load(std::memory_order_acquire) != nullptr) {
+                    std::this_thread::yield();
+                }
+                void *p = subject.Alloc(op.size);
+                if (p != nullptr) {
+                    live.fetch_add(op.size, std::memory_order_relaxed);
+                } else {
+                    failures++;
+                    p = &failed;
+                }
+                sizes[op.slot] = op.size;
+                slot.store(p, std::memory_order_release);
+            } else {
+                void *p;
+                while ((p = slot.load(std::memory_order_acquire)) == nullptr) {
+                    std::this_thread::yield();
+                }
+                if (p != &failed) {
+                    subject.Free(p, sizes[op.slot]);
+                    live.fetch_sub(sizes[op.slot], std::memory_order_relaxed);
+                }
+                slot.store(nullptr, std::memory_order_release);
+            }
+
+            // The first thread samples the state of the whole allocator
+            if (t == 0 && period != 0 && (i + 1) % period == 0 && result.fragmentation.size() < samples) {
+                std::size_t bytes = live.load(std::memory_order_relaxed);
+                std::size_t footprint = subject.Footprint();
+                footprint -= std::min(baseline, footprint);
+                result.fragmentation.push_back(footprint > bytes ? 1 - double(bytes) / footprint : 0);
+            }
+        }
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < trace.threads.size(); t++) {
+        threads.emplace_back(run, t);
+    }
+    run(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto spent = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+
+    result.seconds = spent.count() / 1e6;
+    for (auto &ops : trace.threads) {
+        result.ops += ops.size();
+    }
+    result.failures = failures.load();
+
+    // Objects left by the trace, not timed
+    for (std::size_t i = 0; i < trace.slots; i++) {
+        void *p = pointers[i].load();
+        if (p != nullptr && p != &failed) {
+            subject.Free(p, sizes[i]);
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> Split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+} // namespace
+
+/**
+ * Replays synthetic or recorded traces against Simple, slab allocators behind Pooled and glibc malloc.
+ * Each run goes in the forked process, so that memory one allocator keeps doesn't affect the next one,
+ * and reports throughput, peak RSS growth and fragmentation sampled over the trace
+ */
+int main(int argc, char **argv) {
+    cxxopts::Options options("afina-allocator-bench", "Compares allocators on alloc/free traces");
+    try {
+        options.add_options()("traces", "Synthetic traces: uniform, zipf, churn, handoff",
+                              cxxopts::value<std::string>()->default_value("uniform,zipf,churn,handoff"));
+        options.add_options()("allocators", "Allocators: malloc, simple, pooled",
+                              cxxopts::value<std::string>()->default_value("malloc,simple,pooled"));
+        options.add_options()("threads", "Threads replaying synthetic traces",
+                              cxxopts::value<std::size_t>()->default_value("4"));
+        options.add_options()("ops", "Operations per thread", cxxopts::value<std::size_t>()->default_value("1000000"));
+        options.add_options()("live", "Live objects per thread", cxxopts::value<std::size_t>()->default_value("20000"));
+        options.add_options()("area", "Size of the Simple area",
+                              cxxopts::value<std::size_t>()->default_value("1073741824"));
+        options.add_options()("samples", "Fragmentation samples per run",
+                              cxxopts::value<std::size_t>()->default_value("8"));
+        options.add_options()("replay", "Replay recorded trace instead of synthetic ones",
+                              cxxopts::value<std::string>());
+        options.add_options()("record", "Save the single synthetic trace to the file", cxxopts::value<std::string>());
+        options.add_options()("h,help", "Print usage info");
+        options.parse(argc, argv);
+
+        if (options.count("help") > 0) {
+            std::cerr << options.help() << std::endl;
+            return 0;
+        }
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<Trace> traces;
+        if (options.count("replay") > 0) {
+            traces.push_back(Load(options["replay"].as<std::string>()));
+        } else {
+            std::size_t threads = options["threads"].as<std::size_t>();
+            for (const std::string &kind : Split(options["traces"].as<std::string>())) {
+                // Handoff needs the pair of threads at least
+                std::size_t count = kind == "handoff" ? std::max<std::size_t>(2, threads & ~std::size_t(1)) : threads;
+                traces.push_back(
+                    Generate(kind, count, options["ops"].as<std::size_t>(), options["live"].as<std::size_t>()));
+            }
+        }
+
+        if (options.count("record") > 0) {
+            if (traces.size() != 1) {
+                throw std::runtime_error("Only the single trace could be recorded");
+            }
+            Save(traces[0], options["record"].as<std::string>());
+        }
+
+        std::size_t samples = options["samples"].as<std::size_t>();
+        std::printf("%-9s %-7s %4s %10s %8s %10s %8s  %s\n", "trace", "alloc", "thr", "ops", "Mops/s", "peak RSS",
+                    "failed", "fragmentation over time");
+        for (const Trace &trace : traces) {
+            for (const std::string &name : Split(options["allocators"].as<std::string>())) {
+                std::fflush(stdout);
+                pid_t child = fork();
+                if (child < 0) {
+                    throw std::runtime_error("Failed to fork");
+                } else if (child > 0) {
+                    int status;
+                    waitpid(child, &status, 0);
+                    continue;
+                }
+
+                // Peak RSS gets reset, so that it counts from the trace already in memory
+                std::ofstream("/proc/self/clear_refs") << "5";
+                std::size_t before = Status("VmRSS:");
+                std::unique_ptr<Subject> subject = Create(name, options["area"].as<std::size_t>());
+                Result result = Replay(trace, *subject, samples);
+                std::size_t peak = Status("VmHWM:");
+
+                std::string series;
+                for (double f : result.fragmentation) {
+                    char value[16];
+                    std::snprintf(value, sizeof(value), " %.2f", f);
+                    series += value;
+                }
+                std::printf("%-9s %-7s %4zu %10zu %8.2f %8.1fMB %8zu %s\n", trace.name.c_str(), name.c_str(),
+                            trace.threads.size(), result.ops, result.ops / result.seconds / 1e6,
+                            (peak > before ? peak - before : 0) / 1024.0, result.failures, series.c_str());
+                std::fflush(stdout);
+                _exit(0);
+            }
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
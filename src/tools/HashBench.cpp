@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/KeyHash.h"
+
+using Afina::Backend::KeyHash;
+
+namespace {
+
+// Keys are taken round robin from the set larger than L1 cache, as index lookups would see them
+const std::size_t kKeys = 4096;
+const std::size_t kRounds = 2000;
+
+// Returns nanoseconds per call of the given function over all keys
+template <typename F> double Measure(const std::vector<std::string> &keys, F f) {
+    uint64_t sink = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < kRounds; round++) {
+        for (auto &key : keys) {
+            sink += f(key);
+        }
+    }
+    auto spent = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+
+    // Compiler has to assume the result is used, so the loop isn't thrown away
+    asm volatile("" : : "r"(sink));
+    return double(spent.count()) / (kRounds * keys.size());
+}
+
+} // namespace
+
+/**
+ * Compares KeyHash with std::hash and string comparison on keys of the typical sizes
+ */
+int main() {
+    std::mt19937_64 random(42);
+    std::printf("key comparison: %s\n", KeyHash::Implementation());
+    std::printf("%6s %12s %12s %12s %12s %12s\n", "size", "std::hash", "KeyHash", "operator==", "memcmp",
+                "KeyHash::Eq");
+
+    for (std::size_t size : {8, 16, 24, 40, 64, 100, 256, 1024}) {
+        std::vector<std::string> keys(kKeys), copies(kKeys);
+        for (std::size_t i = 0; i < kKeys; i++) {
+            for (std::size_t j = 0; j < size; j++) {
+                keys[i].push_back(char('a' + random() % 26));
+            }
+            copies[i] = keys[i];
+        }
+
+        // Comparisons check equal keys: the case index lookup can't cut short
+        std::hash<std::string> std_hash;
+        std::size_t i = 0;
+        double std_ns = Measure(keys, [&std_hash](const std::string &key) { return std_hash(key); });
+        double key_ns = Measure(keys, [](const std::string &key) { return KeyHash::Compute(key.data(), key.size()); });
+        double eq_ns = Measure(keys, [&copies, &i](const std::string &key) { return key == copies[i++ % kKeys]; });
+        double memcmp_ns = Measure(keys, [&copies, &i](const std::string &key) {
+            const std::string &copy = copies[i++ % kKeys];
+            return key.size() == copy.size() && std::memcmp(key.data(), copy.data(), key.size()) == 0;
+        });
+        double simd_ns =
+            Measure(keys, [&copies, &i](const std::string &key) { return KeyHash::Equal(key, copies[i++ % kKeys]); });
+
+        std::printf("%6zu %10.2fns %10.2fns %10.2fns %10.2fns %10.2fns\n", size, std_ns, key_ns, eq_ns, memcmp_ns,
+                    simd_ns);
+    }
+    return 0;
+}
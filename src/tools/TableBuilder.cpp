@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+
+#include "storage/MappedTable.h"
+
+/**
+ * Builds immutable dataset for the "mapped_table" storage out of text file. Each line of the input
+ * is a key and a value separated by the tab, duplicates are resolved in favor of the last line.
+ * Input is mapped into memory, only positions of the lines are kept in heap while sorting
+ */
+int main(int argc, char **argv) {
+    cxxopts::Options options("afina-table-builder", "Builds immutable dataset for afina");
+    try {
+        options.add_options()("i,input", "Text file with tab separated keys and values", cxxopts::value<std::string>());
+        options.add_options()("o,output", "Table file to create", cxxopts::value<std::string>());
+        options.add_options()("h,help", "Print usage info");
+        options.parse(argc, argv);
+
+        if (options.count("help") > 0 || options.count("input") == 0 || options.count("output") == 0) {
+            std::cerr << options.help() << std::endl;
+            return options.count("help") > 0 ? 0 : 1;
+        }
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    struct Line {
+        const char *key;
+        uint32_t key_size;
+        const char *value;
+        uint32_t value_size;
+    };
+
+    try {
+        std::string input = options["input"].as<std::string>();
+        int fd = open(input.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            throw std::runtime_error("Failed to open " + input + ": " + std::strerror(errno));
+        }
+
+        std::size_t size = st.st_size;
+        const char *data = nullptr;
+        if (size > 0) {
+            void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("Failed to map " + input + ": " + std::strerror(errno));
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(mapped);
+        }
+        close(fd);
+
+        std::vector<Line> lines;
+        for (const char *p = data, *end = data + size; p < end;) {
+            const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (eol == nullptr) {
+                eol = end;
+            }
+
+            const char *tab = static_cast<const char *>(std::memchr(p, '\t', eol - p));
+            if (tab == nullptr) {
+                throw std::runtime_error("Line " + std::to_string(lines.size() + 1) + " has no tab");
+            }
+            lines.push_back(Line{p, static_cast<uint32_t>(tab - p), tab + 1, static_cast<uint32_t>(eol - tab - 1)});
+            p = eol + 1;
+        }
+
+        // Stable sort keeps lines with the same key in the input order, so the last one wins
+        std::stable_sort(lines.begin(), lines.end(), [](const Line &a, const Line &b) {
+            int result = std::memcmp(a.key, b.key, std::min(a.key_size, b.key_size));
+            return result < 0 || (result == 0 && a.key_size < b.key_size);
+        });
+
+        Afina::Backend::MappedTableWriter writer(options["output"].as<std::string>());
+        std::size_t items = 0;
+        for (std::size_t i = 0; i < lines.size(); i++) {
+            const Line &line = lines[i];
+            if (i + 1 < lines.size() && line.key_size == lines[i + 1].key_size &&
+                std::memcmp(line.key, lines[i + 1].key, line.key_size) == 0) {
+                continue;
+            }
+            writer.Add(line.key, line.key_size, line.value, line.value_size);
+            items++;
+        }
+        writer.Finish();
+
+        std::cerr << "Written " << items << " items" << std::endl;
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/Pooled.h>
+#include <afina/allocator/SlabCache.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static bool isAligned(void *p, size_t alignment) { return reinterpret_cast<uintptr_t>(p) % alignment == 0; }
+
+TEST(MempoolTest, ArenaSlabs) {
+    Arena arena(64 << 10, 1 << 20);
+
+    set<void *> slabs;
+    for (int i = 0; i < 20; i++) {
+        void *slab = arena.Alloc();
+        ASSERT_NE(slab, nullptr);
+        EXPECT_TRUE(isAligned(slab, 64 << 10));
+        EXPECT_TRUE(slabs.insert(slab).second);
+    }
+    EXPECT_EQ(2 << 20, arena.Mapped());
+
+    arena.Free(*slabs.begin());
+    EXPECT_EQ(*slabs.begin(), arena.Alloc());
+    EXPECT_EQ(2 << 20, arena.Mapped());
+}
+
+TEST(MempoolTest, ArenaHugePages) {
+    // Whether kernel gives huge pages depends on the system, so only the bounds are checked
+    Arena arena(2 << 20, 8 << 20, true);
+    EXPECT_TRUE(arena.HugePages());
+    EXPECT_EQ(0, arena.HugeBytes());
+
+    for (int i = 0; i < 4; i++) {
+        char *slab = static_cast<char *>(arena.Alloc());
+        ASSERT_NE(slab, nullptr);
+        EXPECT_TRUE(isAligned(slab, 2 << 20));
+        for (size_t offset = 0; offset < (2 << 20); offset += 4096) {
+            slab[offset] = char(i);
+        }
+    }
+    EXPECT_EQ(8 << 20, arena.Mapped());
+    EXPECT_LE(arena.HugeBytes(), arena.Mapped());
+
+    vector<pair<string, string>> stats;
+    Pooled::Stats(stats);
+    ASSERT_EQ(5, stats.size());
+    EXPECT_EQ("pool_hugepage_coverage", stats.back().first);
+}
+
+TEST(MempoolTest, SlabCacheSplit) {
+    Arena arena(64 << 10, 1 << 20);
+    SlabCache cache(arena);
+
+    EXPECT_EQ(8192, cache.Size(5000));
+    EXPECT_EQ(0, cache.Size(1 << 20));
+
+    // Arena slab gets split down to the requested size, halves serve the next requests
+    void *a = cache.Alloc(5000);
+    void *b = cache.Alloc(8192);
+    void *c = cache.Alloc(16384);
+    EXPECT_TRUE(isAligned(a, 8192));
+    EXPECT_TRUE(isAligned(b, 8192));
+    EXPECT_TRUE(isAligned(c, 16384));
+    EXPECT_EQ(static_cast<char *>(a) + 8192, b);
+    EXPECT_EQ(static_cast<char *>(a) + 16384, c);
+
+    cache.Free(a, 8192);
+    EXPECT_EQ(a, cache.Alloc(8192));
+}
+
+TEST(MempoolTest, Reuse) {
+    Arena arena(64 << 10, 1 << 20);
+    SlabCache cache(arena);
+    Mempool pool(cache, 40);
+    EXPECT_EQ(48, pool.ObjectSize());
+
+    set<void *> objects;
+    for (int i = 0; i < 1000; i++) {
+        void *object = pool.Alloc();
+        ASSERT_NE(object, nullptr);
+        EXPECT_TRUE(isAligned(object, Mempool::kAlignment));
+        EXPECT_TRUE(objects.insert(object).second);
+    }
+
+    size_t size = pool.Size();
+    for (void *object : objects) {
+        pool.Free(object);
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(1, objects.count(pool.Alloc()));
+    }
+    EXPECT_EQ(size, pool.Size());
+}
+
+TEST(MempoolTest, Threads) {
+    Arena arena(64 << 10, 1 << 20);
+    SlabCache cache(arena);
+    Mempool pool(cache, 64);
+
+    // Each thread marks its objects and checks nobody else got them
+    vector<thread> threads;
+    vector<int> errors(8, 0);
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&pool, &errors, t]() {
+            vector<uint64_t *> objects;
+            for (int round = 0; round < 200; round++) {
+                for (int i = 0; i < 100; i++) {
+                    uint64_t *object = static_cast<uint64_t *>(pool.Alloc());
+                    for (int j = 0; j < 8; j++) {
+                        object[j] = t;
+                    }
+                    objects.push_back(object);
+                }
+                for (uint64_t *object : objects) {
+                    for (int j = 0; j < 8; j++) {
+                        errors[t] += object[j] != uint64_t(t);
+                    }
+                    pool.Free(object);
+                }
+                objects.clear();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < 8; t++) {
+        EXPECT_EQ(0, errors[t]);
+    }
+}
+
+namespace {
+
+struct Small : public Pooled {
+    char data[100];
+};
+
+struct Large : public Pooled {
+    char data[Pooled::kMaxSize + 1];
+};
+
+} // namespace
+
+TEST(MempoolTest, Pooled) {
+    Small *a = new Small();
+    delete a;
+    Small *b = new Small();
+    EXPECT_EQ(a, b);
+    delete b;
+
+    Large *large = new Large();
+    large->data[Pooled::kMaxSize] = 1;
+    delete large;
+}
+
+TEST(MempoolTest, ThreadCaches) {
+    // Objects freed by the thread stay in its magazine up to the high-water mark, the rest go back to the
+    // pool, and everything goes back once thread exits, so the next threads need no more slabs. Threads
+    // wait for each other before freeing, so that each round reaches the same peak
+    size_t size = 0;
+    for (int round = 0; round < 3; round++) {
+        atomic<int> allocated(0);
+        vector<thread> threads;
+        for (int t = 0; t < 8; t++) {
+            threads.emplace_back([&allocated]() {
+                vector<Small *> objects;
+                for (int i = 0; i < 10000; i++) {
+                    objects.push_back(new Small());
+                }
+                allocated++;
+                while (allocated.load() < 8) {
+                    this_thread::yield();
+                }
+                for (Small *object : objects) {
+                    delete object;
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (round == 0) {
+            size = Pooled::Size();
+        }
+        EXPECT_EQ(size, Pooled::Size());
+    }
+}
@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 #include <iostream>
+#include <map>
 #include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include <afina/allocator/Error.h>
@@ -274,6 +277,52 @@ TEST(SimpleTest, ReallocGrowInplace) {
     a.free(p2);
 }
 
+// Grows four interleaved allocations by small steps, returns how many times they moved
+static int growInterleaved(Simple &a) {
+    vector<Pointer> ptrs;
+    for (int i = 0; i < 4; i++) {
+        ptrs.push_back(a.alloc(16));
+    }
+
+    int moves = 0;
+    for (int size = 32; size <= 2048; size += 16) {
+        for (Pointer &p : ptrs) {
+            void *before = p.get();
+            a.realloc(p, size);
+            writeTo(p, size);
+            moves += p.get() != before;
+        }
+    }
+    for (Pointer &p : ptrs) {
+        EXPECT_TRUE(isDataOk(p, 2048));
+        a.free(p);
+    }
+    return moves;
+}
+
+TEST(SimpleTest, ReallocBuddy) {
+    Simple a(buf, sizeof(buf));
+    EXPECT_FALSE(a.buddy());
+    int moves = growInterleaved(a);
+
+    // Blocks double from 64 to 4096 bytes, so each allocation moves about once per power of two
+    a.buddy(true);
+    EXPECT_TRUE(a.buddy());
+    int buddy_moves = growInterleaved(a);
+    EXPECT_LE(buddy_moves, 4 * 7);
+    EXPECT_LT(buddy_moves * 2, moves);
+
+    // Block is the power of two including the head, so the rest of it is free to grow into
+    Pointer p = a.alloc(100);
+    void *ptr = p.get();
+    a.realloc(p, 112);
+    EXPECT_EQ(ptr, p.get());
+    EXPECT_EQ(128, a.used());
+
+    Simple attached(buf, sizeof(buf), true);
+    EXPECT_TRUE(attached.buddy());
+}
+
 TEST(SimpleTest, ReallocShrink) {
     Simple a(buf, sizeof(buf));
 
@@ -322,3 +371,136 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, FreeCoalesce) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 135;
+
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+    for (size_t i = 0; i < ptrs.size(); i += 2) {
+        a.free(ptrs[i]);
+    }
+    for (size_t i = 1; i < ptrs.size(); i += 2) {
+        a.free(ptrs[i]);
+    }
+    EXPECT_EQ(a.used(), 0);
+
+    Pointer p = a.alloc(sizeof(buf) / 2);
+    writeTo(p, sizeof(buf) / 2);
+    EXPECT_TRUE(isDataOk(p, sizeof(buf) / 2));
+    a.free(p);
+}
+
+TEST(SimpleTest, FreeInvalid) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SimpleTest, CompactPointer) {
+    Simple a(buf, sizeof(buf));
+    EXPECT_EQ(0, a.compact(0));
+    EXPECT_EQ(0, a.expand(0));
+
+    // Handles are taken from the top of the table, so compact numbers stay small
+    vector<Pointer> ptrs;
+    for (int i = 0; i < 100; i++) {
+        ptrs.push_back(a.alloc(16));
+        *static_cast<int *>(ptrs.back().get()) = i;
+    }
+    for (int i = 0; i < 100; i++) {
+        uint32_t handle = a.compact(ptrs[i].offset());
+        EXPECT_GT(handle, 0);
+        EXPECT_LE(handle, 128);
+        EXPECT_EQ(ptrs[i].offset(), a.expand(handle));
+        EXPECT_EQ(i, *static_cast<int *>(a.get(a.expand(handle)).get()));
+    }
+
+    for (int i = 0; i < 100; i += 2) {
+        a.free(ptrs[i]);
+    }
+    a.defrag();
+    for (int i = 1; i < 100; i += 2) {
+        EXPECT_EQ(i, *static_cast<int *>(a.get(a.expand(a.compact(ptrs[i].offset()))).get()));
+    }
+}
+
+TEST(SimpleTest, Dump) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    ASSERT_TRUE(fillUp(a, 100, ptrs));
+    for (size_t i = 0; i < ptrs.size(); i += 2) {
+        a.free(ptrs[i]);
+    }
+    // Filling up fails once and so does the allocation larger than any hole
+    EXPECT_THROW(a.alloc(1000), AllocError);
+    a.defrag();
+
+    map<string, string> values;
+    istringstream lines(a.dump());
+    string name, value;
+    while (lines >> name >> value) {
+        EXPECT_EQ(0, values.count(name));
+        values[name] = value;
+    }
+
+    EXPECT_EQ(to_string(sizeof(buf)), values["size"]);
+    EXPECT_EQ(to_string(a.used()), values["used"]);
+    EXPECT_EQ(values["available"], values["largest_free"]);
+    EXPECT_EQ("1", values["free_blocks"]);
+    EXPECT_EQ(to_string(ptrs.size() / 2), values["used_blocks"]);
+    EXPECT_EQ(to_string(ptrs.size() / 2), values["handles_used"]);
+    EXPECT_EQ("2", values["alloc_failures"]);
+    EXPECT_EQ("1", values["defrag_runs"]);
+    EXPECT_LT(0, stoul(values["defrag_bytes"]));
+
+    // Allocations are at the beginning of the area after compaction
+    EXPECT_LT(0.9, stod(values["region_0_utilization"]));
+    EXPECT_EQ(0, stod(values["region_15_utilization"]));
+}
+
+TEST(SimpleTest, DefragIncremental) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs, kept;
+    int size = 135;
+
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        if (i % 2 == 0) {
+            a.free(ptrs[i]);
+        } else {
+            kept.push_back(ptrs[i]);
+        }
+    }
+    EXPECT_GT(a.fragmentation(), 0.9);
+
+    // Each step moves a single allocation, data stays in place between steps
+    int steps = 0;
+    while (a.defrag(size, 0) != 0) {
+        steps++;
+        EXPECT_TRUE(isDataOk(kept[steps % kept.size()], size));
+    }
+    EXPECT_GT(steps, 1);
+    EXPECT_EQ(a.fragmentation(), 0);
+
+    Pointer p = a.alloc(sizeof(buf) / 3);
+    writeTo(p, sizeof(buf) / 3);
+    for (Pointer &p : kept) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+    a.free(p);
+}
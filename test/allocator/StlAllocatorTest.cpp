@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include <list>
+#include <map>
+#include <string>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/StlAllocator.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static char area[65536];
+
+using String = basic_string<char, char_traits<char>, StlAllocator<char>>;
+
+static bool inArea(const void *p) { return p >= area && p < area + sizeof(area); }
+
+TEST(StlAllocatorTest, String) {
+    Simple a(area, sizeof(area));
+    StlAllocator<char> allocator(a);
+
+    String s(allocator);
+    for (int i = 0; i < 100; i++) {
+        s += "0123456789";
+    }
+    EXPECT_TRUE(inArea(s.data()));
+    EXPECT_EQ(1000, s.size());
+    EXPECT_EQ(0, s.compare(990, 10, "0123456789"));
+
+    s.clear();
+    s.shrink_to_fit();
+    EXPECT_LT(a.used(), 1000);
+}
+
+TEST(StlAllocatorTest, Containers) {
+    Simple a(area, sizeof(area));
+    StlAllocator<int> allocator(a);
+
+    {
+        list<int, StlAllocator<int>> values(allocator);
+        map<int, int, less<int>, StlAllocator<pair<const int, int>>> squares(allocator);
+        for (int i = 0; i < 100; i++) {
+            values.push_back(i);
+            squares[i] = i * i;
+        }
+
+        EXPECT_TRUE(inArea(&values.back()));
+        EXPECT_TRUE(inArea(&squares[50]));
+        EXPECT_EQ(2500, squares[50]);
+        EXPECT_GT(a.used(), 0);
+    }
+
+    // All memory returns to the area
+    EXPECT_EQ(0, a.used());
+}
+
+TEST(StlAllocatorTest, NoMemory) {
+    Simple a(area, sizeof(area));
+    list<string, StlAllocator<string>> values{StlAllocator<string>(a)};
+
+    EXPECT_THROW(
+        {
+            for (int i = 0; i < 100000; i++) {
+                values.emplace_back("value");
+            }
+        },
+        bad_alloc);
+}
+
+TEST(StlAllocatorTest, Foreign) {
+    Simple a(area, sizeof(area));
+    Pointer p = a.alloc(100);
+
+    EXPECT_EQ(p.offset(), a.at(p.get()).offset());
+    try {
+        a.at(static_cast<char *>(p.get()) + 8);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+    a.free(p);
+}
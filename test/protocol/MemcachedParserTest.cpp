@@ -3,9 +3,13 @@
 #include <memory>
 #include <string>
 
+#include <afina/KeyHash.h>
 #include <afina/execute/Add.h>
+#include <afina/execute/DeletePrefix.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Scan.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Snapshot.h>
 #include <afina/execute/Stats.h>
 
 #include <protocol/Parser.h>
@@ -98,3 +102,122 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+TEST(MemcachedParserTest, StatsGroup) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("stats allocator\r\n", consumed));
+    ASSERT_EQ(17, consumed);
+    ASSERT_EQ("stats", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Stats *stats = dynamic_cast<Execute::Stats *>(cmd.get());
+    ASSERT_FALSE(stats == nullptr);
+    ASSERT_EQ("allocator", stats->group());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("stats allocator slabs\r\n", consumed));
+    EXPECT_THROW(parser.Build(value_size), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, Snapshot) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("snapshot\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(10, consumed);
+    ASSERT_EQ("snapshot", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Snapshot *>(cmd.get()) == nullptr);
+}
+
+TEST(MemcachedParserTest, DeletePrefix) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("delete_prefix user:123:\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(25, consumed);
+    ASSERT_EQ("delete_prefix", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::DeletePrefix *tmp = reinterpret_cast<Execute::DeletePrefix *>(cmd.get());
+    ASSERT_EQ("user:123:", tmp->prefix());
+}
+
+TEST(MemcachedParserTest, Scan) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("scan user: 0 100\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(18, consumed);
+    ASSERT_EQ("scan", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Scan *tmp = reinterpret_cast<Execute::Scan *>(cmd.get());
+    ASSERT_EQ("user:", tmp->prefix());
+    ASSERT_EQ("0", tmp->cursor());
+    ASSERT_EQ(100, tmp->count());
+}
+
+TEST(MemcachedParserTest, ScanBadCount) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("scan user: 0 1x\r\n", consumed));
+
+    size_t value_size;
+    ASSERT_THROW(parser.Build(value_size), std::runtime_error);
+}
+
+// Verify keys get hashed by parser, even once key comes in pieces
+TEST(MemcachedParserTest, KeyHashes) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_FALSE(parser.Parse("get foo ba", consumed));
+    ASSERT_TRUE(parser.Parse("rbaz\r\n", consumed));
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Get *get = reinterpret_cast<Execute::Get *>(cmd.get());
+    ASSERT_EQ(2, get->hashes().size());
+    ASSERT_EQ(KeyHash::Compute("foo", 3), get->hashes()[0]);
+    ASSERT_EQ(KeyHash::Compute("barbaz", 6), get->hashes()[1]);
+
+    // Long key is hashed piece by piece as it arrives
+    std::string key(200, 'k');
+    for (size_t i = 0; i < key.size(); i++) {
+        key[i] = 'a' + (i * 7) % 26;
+    }
+    parser.Reset();
+    ASSERT_FALSE(parser.Parse("get " + key.substr(0, 30), consumed));
+    ASSERT_FALSE(parser.Parse(key.substr(30, 100), consumed));
+    ASSERT_TRUE(parser.Parse(key.substr(130) + "\r\n", consumed));
+    cmd = parser.Build(value_size);
+    get = reinterpret_cast<Execute::Get *>(cmd.get());
+    ASSERT_EQ(1, get->hashes().size());
+    ASSERT_EQ(key, get->keys()[0]);
+    ASSERT_EQ(KeyHash::Compute(key.data(), key.size()), get->hashes()[0]);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 0 6\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(KeyHash::Compute("foo", 3), reinterpret_cast<Execute::Set *>(cmd.get())->hash());
+}
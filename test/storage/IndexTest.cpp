@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/ArtIndex.h"
+#include "storage/HashIndex.h"
+#include "storage/MapIndex.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+struct entry {
+    std::string key;
+};
+
+static std::unique_ptr<Index<entry>> make_index(IndexType type) {
+    switch (type) {
+    case IndexType::kMap:
+        return std::unique_ptr<Index<entry>>(new MapIndex<entry>());
+    case IndexType::kHash:
+        return std::unique_ptr<Index<entry>>(new HashIndex<entry>());
+    case IndexType::kArt:
+        return std::unique_ptr<Index<entry>>(new ArtIndex<entry>());
+    }
+    return nullptr;
+}
+
+// Keys with long shared prefixes, keys which are prefixes of each other and binary bytes
+static std::vector<std::string> make_keys(size_t count) {
+    std::mt19937 rnd(42);
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; i++) {
+        std::string key = "user:" + std::to_string(rnd() % 200) + ":session:";
+        size_t tail = rnd() % 6;
+        for (size_t j = 0; j < tail; j++) {
+            key.push_back(static_cast<char>(rnd() % 256));
+        }
+        result.push_back(key);
+    }
+    result.push_back("");
+    result.push_back("u");
+    result.push_back("user:");
+    result.push_back(std::string(40, 'x'));
+    result.push_back(std::string(41, 'x'));
+    result.push_back(std::string(20, 'x') + "y" + std::string(20, 'x'));
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    std::shuffle(result.begin(), result.end(), rnd);
+    return result;
+}
+
+class IndexTest : public ::testing::TestWithParam<IndexType> {};
+
+TEST_P(IndexTest, InsertFindErase) {
+    auto index = make_index(GetParam());
+    auto keys = make_keys(20000);
+
+    std::vector<entry> entries(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        entries[i].key = keys[i];
+        index->Insert(&entries[i]);
+    }
+    EXPECT_EQ(keys.size(), index->Size());
+
+    for (auto &e : entries) {
+        EXPECT_EQ(&e, index->Find(e.key));
+        EXPECT_EQ(nullptr, index->Find(e.key + "\x01missing"));
+    }
+
+    for (size_t i = 0; i < entries.size(); i += 2) {
+        EXPECT_EQ(&entries[i], index->Erase(entries[i].key));
+        EXPECT_EQ(nullptr, index->Erase(entries[i].key));
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ((i % 2) ? &entries[i] : nullptr, index->Find(entries[i].key));
+    }
+
+    for (size_t i = 1; i < entries.size(); i += 2) {
+        EXPECT_EQ(&entries[i], index->Erase(entries[i].key));
+    }
+    EXPECT_EQ(0, index->Size());
+}
+
+TEST_P(IndexTest, PrefixWalk) {
+    auto index = make_index(GetParam());
+    auto keys = make_keys(5000);
+
+    std::vector<entry> entries(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        entries[i].key = keys[i];
+        index->Insert(&entries[i]);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    for (const std::string prefix : {"", "user:1", "user:17:session:", "x", "zzz"}) {
+        std::vector<std::string> expected;
+        for (auto &k : keys) {
+            if (k.compare(0, prefix.size(), prefix) == 0) {
+                expected.push_back(k);
+            }
+        }
+
+        // Walk in small portions continuing after the last key seen
+        std::vector<std::string> actual;
+        std::string after;
+        bool more = true;
+        while (more) {
+            size_t seen = 0;
+            bool ordered = index->Walk(prefix, after, [&](entry *e) {
+                actual.push_back(e->key);
+                after = e->key;
+                return ++seen < 7;
+            });
+            if (!ordered) {
+                return;
+            }
+            more = (seen == 7);
+        }
+        EXPECT_EQ(expected, actual) << "prefix: " << prefix;
+    }
+}
+
+// Hash is the key itself, so that test controls which buckets keys land into
+struct number_hash {
+    std::size_t operator()(const std::string &key) const { return std::stoul(key); }
+};
+
+TEST(HashIndexTest, EraseDuringRehash) {
+    HashIndex<entry, number_hash> index;
+    std::vector<entry> entries(17);
+    for (size_t i = 0; i < 16; i++) {
+        entries[i].key = std::to_string(i);
+        index.Insert(&entries[i]);
+    }
+
+    // Table is full, so that insert starts the resize. Key lands into the last bucket of the old table which
+    // isn't migrated yet, while slot itself goes into the new table
+    entries[16].key = "31";
+    index.Insert(&entries[16]);
+    ASSERT_TRUE(index.Rehashing());
+    EXPECT_EQ(&entries[16], index.Erase("31"));
+
+    while (index.Maintain(1)) {
+    }
+    EXPECT_EQ(16, index.Size());
+    for (size_t i = 0; i < 16; i++) {
+        EXPECT_EQ(&entries[i], index.Find(entries[i].key));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Indexes, IndexTest, ::testing::Values(IndexType::kMap, IndexType::kHash, IndexType::kArt));
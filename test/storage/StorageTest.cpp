@@ -1,16 +1,38 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <random>
 #include <set>
 #include <vector>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/StlAllocator.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "storage/AdaptiveStorage.h"
+#include "storage/CompressedStorage.h"
+#include "storage/Crc32c.h"
+#include "storage/KeyHash.h"
+#include "storage/LogStorage.h"
+#include "storage/MapIndex.h"
+#include "storage/Lz.h"
+#include "storage/MappedTable.h"
+#include "storage/ShardedLRU.h"
+#include "storage/SharedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SnapshotStorage.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TieredLRU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -195,3 +217,1091 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, MapIndexInArea) {
+    struct Entry {
+        std::string key;
+    };
+
+    std::vector<char> area(1 << 16);
+    Afina::Allocator::Simple arena(area.data(), area.size());
+    std::vector<Entry> entries(100);
+    {
+        MapIndex<Entry, Afina::Allocator::StlAllocator<Entry *>> index{
+            Afina::Allocator::StlAllocator<Entry *>(arena)};
+        for (int i = 0; i < 100; ++i) {
+            entries[i].key = "Key " + std::to_string(1000 + i);
+            index.Insert(&entries[i]);
+        }
+        EXPECT_GT(arena.used(), 100 * 32);
+
+        EXPECT_EQ(&entries[42], index.Find("Key 1042"));
+        EXPECT_EQ(&entries[42], index.Erase("Key 1042"));
+        EXPECT_EQ(nullptr, index.Find("Key 1042"));
+
+        std::vector<std::string> keys;
+        index.Walk("Key 104", "", [&keys](Entry *entry) {
+            keys.push_back(entry->key);
+            return true;
+        });
+        EXPECT_EQ(9, keys.size());
+    }
+    EXPECT_EQ(0, arena.used());
+}
+
+TEST(StorageTest, HashIndexGrowShrink) {
+    const size_t length = 20;
+    SimpleLRU storage(2 * 100000 * length, IndexType::kHash);
+
+    for (long i = 0; i < 100000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // Some keys are in the middle of migration, all of them must be reachable anyway
+    for (long i = 0; i < 100000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+
+    for (long i = 0; i < 99000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Delete(key));
+    }
+
+    for (long i = 0; i < 100000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_EQ(i >= 99000, storage.Get(key, res));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ("1000", values["curr_items"]);
+    EXPECT_NE("0", values["index_rehash_total"]);
+}
+
+TEST(StorageTest, HashIndexMaxTest) {
+    const size_t length = 20;
+    SimpleLRU storage(2 * 1000 * length, IndexType::kHash);
+
+    for (long i = 0; i < 1100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    for (long i = 0; i < 1100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_EQ(i >= 100, storage.Get(key, res));
+        if (i >= 100) {
+            EXPECT_TRUE(val == res);
+        }
+    }
+}
+
+TEST(StorageTest, HashIndexBackgroundRehash) {
+    const size_t length = 20;
+    ThreadSafeSimplLRU storage(4 * 10000 * length, IndexType::kHash);
+    storage.Start();
+
+    for (long i = 0; i < 10000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // Background thread finishes migration without any client operations
+    std::map<std::string, std::string> values;
+    for (int i = 0; i < 100; i++) {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+
+        values = std::map<std::string, std::string>(stats.begin(), stats.end());
+        if (values["index_rehashing"] == "0") {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ("0", values["index_rehashing"]);
+
+    for (long i = 0; i < 10000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+    storage.Stop();
+}
+
+TEST(StorageTest, BackgroundEviction) {
+    const size_t length = 20;
+    ThreadSafeSimplLRU storage(2 * 1000 * length);
+    storage.Start();
+
+    for (long i = 0; i < 1100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // Usage goes below low watermark without client operations
+    std::map<std::string, std::string> values;
+    for (int i = 0; i < 100; i++) {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+
+        values = std::map<std::string, std::string>(stats.begin(), stats.end());
+        if (std::stoul(values["bytes"]) <= std::stoul(values["low_watermark_bytes"])) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_LE(std::stoul(values["bytes"]), std::stoul(values["low_watermark_bytes"]));
+    EXPECT_NE("0", values["evictions_background"]);
+
+    // Most recent keys survive
+    for (long i = 1050; i < 1100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+    storage.Stop();
+}
+
+TEST(StorageTest, ScanDeletePrefix) {
+    for (IndexType type : {IndexType::kMap, IndexType::kArt}) {
+        SimpleLRU storage(1024 * 1024, type);
+
+        for (long i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put("user:" + std::to_string(i % 10) + ":session:" + std::to_string(i), "val"));
+        }
+        EXPECT_TRUE(storage.Put("user", "val"));
+        EXPECT_TRUE(storage.Put("users", "val"));
+
+        // Continue scan from the last key seen until portion is short
+        std::vector<std::string> keys;
+        std::string after;
+        while (true) {
+            size_t before = keys.size();
+            EXPECT_TRUE(storage.Scan("user:3:", after, 17, keys));
+            if (keys.size() - before < 17) {
+                break;
+            }
+            after = keys.back();
+        }
+        EXPECT_EQ(100, keys.size());
+        EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+        size_t deleted = 0;
+        EXPECT_TRUE(storage.DeletePrefix("user:3:", 64, deleted));
+        EXPECT_EQ(64, deleted);
+        EXPECT_TRUE(storage.DeletePrefix("user:3:", 64, deleted));
+        EXPECT_EQ(36, deleted);
+
+        std::string value;
+        EXPECT_FALSE(storage.Get("user:3:session:3", value));
+        EXPECT_TRUE(storage.Get("user:4:session:4", value));
+        EXPECT_TRUE(storage.Get("user", value));
+
+        keys.clear();
+        EXPECT_TRUE(storage.Scan("user", "", 2000, keys));
+        EXPECT_EQ(902, keys.size());
+    }
+
+    SimpleLRU storage(1024, IndexType::kHash);
+    std::vector<std::string> keys;
+    EXPECT_FALSE(storage.Scan("user", "", 10, keys));
+}
+
+TEST(StorageTest, FilterNegativeLookup) {
+    const size_t length = 20;
+    SimpleLRU storage(1000 * length, IndexType::kHash, true);
+
+    // Overflow storage so that filter sees evictions, deletions and updates
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+        if (i % 10 == 0) {
+            EXPECT_TRUE(storage.Delete(key));
+        }
+        if (i % 10 == 1) {
+            EXPECT_TRUE(storage.Set(key, pad_space("New " + std::to_string(i), length)));
+        }
+    }
+
+    // No false negatives
+    for (long i = 500; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_EQ(i % 10 != 0, storage.Get(key, res));
+        EXPECT_EQ(i % 10 != 0, storage.MayContain(key));
+    }
+
+    // Most of misses answered by the filter
+    for (long i = 0; i < 1000; ++i) {
+        std::string res;
+        EXPECT_FALSE(storage.Get(pad_space("Missing " + std::to_string(i), length), res));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_GT(std::stoul(values["filter_negatives"]), 900);
+    // Every miss is either answered by the filter or is a false positive, MayContain counts as well
+    EXPECT_EQ(1000 + 2 * 50, std::stoul(values["filter_negatives"]) + std::stoul(values["filter_false_positives"]));
+    EXPECT_EQ(1, values.count("filter_false_positive_rate"));
+}
+
+TEST(StorageTest, Sharded) {
+    const size_t length = 20;
+    ShardedLRU storage(4, 4 * 1000 * length, IndexType::kArt, true);
+    storage.Start();
+
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+
+    // Scan merges keys of all shards in order
+    std::vector<std::string> keys;
+    std::string after;
+    while (true) {
+        size_t before = keys.size();
+        EXPECT_TRUE(storage.Scan("Key 1", after, 17, keys));
+        if (keys.size() - before < 17) {
+            break;
+        }
+        after = keys.back();
+    }
+    EXPECT_EQ(111, keys.size());
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+    size_t deleted = 0;
+    EXPECT_TRUE(storage.DeletePrefix("Key 1", 100, deleted));
+    EXPECT_EQ(100, deleted);
+    EXPECT_TRUE(storage.DeletePrefix("Key 1", 100, deleted));
+    EXPECT_EQ(11, deleted);
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ("4", values["shards"]);
+    EXPECT_EQ("889", values["curr_items"]);
+    EXPECT_EQ(1, values.count("shard3:curr_items"));
+    storage.Stop();
+}
+
+TEST(StorageTest, SnapshotLoad) {
+    const size_t length = 20;
+    const std::string path = "afina-storage-test.snapshot";
+
+    std::shared_ptr<ShardedLRU> source(new ShardedLRU(4, 4 * 1000 * length, IndexType::kHash));
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(source->Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+    EXPECT_TRUE(SnapshotStorage::Write(*source, path));
+
+    // Loads in parallel and restores recency, so that the oldest keys get evicted first
+    std::shared_ptr<ShardedLRU> target(new ShardedLRU(4, 2 * 500 * length, IndexType::kHash));
+    SnapshotStorage storage(target, path);
+    EXPECT_EQ(1000, storage.Load(4));
+
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        if (i >= 900) {
+            EXPECT_TRUE(storage.Get(key, res));
+            EXPECT_TRUE(val == res);
+        } else if (i < 100) {
+            EXPECT_FALSE(storage.Get(key, res));
+        }
+    }
+    std::remove(path.c_str());
+
+    // Missing file is the same as empty one
+    EXPECT_EQ(0, storage.Load(4));
+}
+
+TEST(StorageTest, SnapshotFork) {
+    const size_t length = 20;
+    const std::string path = "afina-storage-test-fork.snapshot";
+
+    std::shared_ptr<ThreadSafeSimplLRU> source(new ThreadSafeSimplLRU(4 * 1000 * length, IndexType::kArt));
+    SnapshotStorage storage(source, path);
+    storage.Start();
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+    EXPECT_TRUE(storage.Snapshot());
+
+    // Changes made after fork don't get into the snapshot
+    EXPECT_TRUE(storage.Delete(pad_space("Key 0", length)));
+    storage.Stop();
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ("1", values["snapshot_total"]);
+    EXPECT_EQ("0", values["snapshot_in_progress"]);
+
+    std::shared_ptr<SimpleLRU> target(new SimpleLRU(2 * 1000 * length));
+    SnapshotStorage loaded(target, path);
+    EXPECT_EQ(1000, loaded.Load(1));
+
+    std::string res;
+    EXPECT_TRUE(loaded.Get(pad_space("Key 0", length), res));
+    EXPECT_TRUE(loaded.Get(pad_space("Key 999", length), res));
+    std::remove(path.c_str());
+}
+
+TEST(StorageTest, Crc32c) {
+    // Check value from RFC 3720
+    EXPECT_EQ(0xe3069283, Crc32c::Compute("123456789", 9));
+
+    std::string data = "The quick brown fox jumps over the lazy dog";
+    EXPECT_EQ(Crc32c::Compute(data.data(), data.size()),
+              Crc32c::Compute(data.data() + 10, data.size() - 10, Crc32c::Compute(data.data(), 10)));
+}
+
+TEST(StorageTest, KeyHash) {
+    std::string key(200, 'k'), other;
+    std::set<uint64_t> hashes;
+    for (size_t size = 0; size <= key.size(); size++) {
+        hashes.insert(KeyHash::Compute(key.data(), size));
+        EXPECT_EQ(KeyHash::Compute(key.data(), size), KeyHash()(key.substr(0, size)));
+
+        // Every byte matters both for the hash and comparison, whatever path the size takes
+        for (size_t i = 0; i < size; i++) {
+            other.assign(key, 0, size);
+            other[i] ^= 1;
+            EXPECT_NE(KeyHash::Compute(key.data(), size), KeyHash::Compute(other.data(), size));
+            EXPECT_FALSE(KeyHash::Equal(key.data(), other.data(), size)) << KeyHash::Implementation();
+        }
+        EXPECT_TRUE(KeyHash::Equal(key.data(), other.assign(key, 0, size).data(), size));
+    }
+    EXPECT_EQ(key.size() + 1, hashes.size());
+    EXPECT_NE(KeyHash::Compute("key", 3), KeyHash::Compute("key", 3, 1));
+
+    // Key coming in pieces of any size hashes the same
+    std::mt19937 rnd(7);
+    for (char &c : key) {
+        c = static_cast<char>(rnd());
+    }
+    for (size_t size = 0; size <= key.size(); size++) {
+        for (size_t piece : {1, 5, 16, 47, 48, 49, 64, 100}) {
+            KeyHash::Stream stream(3);
+            for (size_t done = 0; done < size; done += piece) {
+                stream.Update(key.data() + done, std::min(piece, size - done));
+            }
+            EXPECT_EQ(KeyHash::Compute(key.data(), size, 3), stream.Finish()) << size << " by " << piece;
+        }
+    }
+    EXPECT_FALSE(KeyHash::Equal(std::string("key"), std::string("key2")));
+}
+
+TEST(StorageTest, PrehashedKeys) {
+    std::shared_ptr<ShardedLRU> sharded(new ShardedLRU(4, 1 << 20, IndexType::kHash, true));
+    LogStorage storage(sharded, "afina-prehashed-log", "unlogged");
+    std::string key = "prehashed", value;
+    uint64_t hash = KeyHash::Compute(key.data(), key.size());
+
+    // Both forms of the calls find the same item
+    EXPECT_TRUE(storage.Put(key, hash, "value"));
+    EXPECT_TRUE(storage.Get(key, value));
+    EXPECT_EQ("value", value);
+    EXPECT_TRUE(storage.Append(key, "s"));
+    EXPECT_TRUE(storage.Get(key, hash, value));
+    EXPECT_EQ("values", value);
+    EXPECT_FALSE(storage.PutIfAbsent(key, hash, "other"));
+    EXPECT_TRUE(storage.Set(key, hash, "other"));
+    EXPECT_TRUE(storage.Delete(key));
+    EXPECT_FALSE(storage.Get(key, hash, value));
+    EXPECT_EQ(0, system("rm -rf afina-prehashed-log"));
+}
+
+TEST(StorageTest, LogReplay) {
+    const size_t length = 20;
+    char dir[] = "afina-log-XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+
+    {
+        std::shared_ptr<ShardedLRU> source(new ShardedLRU(4, 4 * 1000 * length, IndexType::kMap));
+        LogStorage storage(source, dir, "Key", 100, 16 * 1024);
+        storage.Start();
+
+        // Concurrent writers share commits
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; t++) {
+            writers.emplace_back([&storage, t, length] {
+                for (long i = t; i < 1000; i += 4) {
+                    auto key = pad_space("Key " + std::to_string(i), length);
+                    EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+
+        EXPECT_TRUE(storage.Put("Other", "not logged"));
+        EXPECT_TRUE(storage.Set(pad_space("Key 1", length), "new"));
+        EXPECT_TRUE(storage.Delete(pad_space("Key 2", length)));
+
+        size_t deleted = 0;
+        EXPECT_TRUE(storage.DeletePrefix("Key 99", 100, deleted));
+        EXPECT_EQ(11, deleted);
+
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        std::map<std::string, std::string> values(stats.begin(), stats.end());
+        EXPECT_EQ("1013", values["log_records"]);
+        EXPECT_GT(std::stoul(values["log_records"]), std::stoul(values["log_commits"]));
+        storage.Stop();
+
+        storage.Stats(stats);
+        values = std::map<std::string, std::string>(stats.begin(), stats.end());
+        EXPECT_NE("0", values["log_compactions"]);
+    }
+
+    // Torn tail of the last segment is ignored
+    {
+        std::shared_ptr<ShardedLRU> target(new ShardedLRU(4, 4 * 1000 * length, IndexType::kMap));
+        LogStorage storage(target, dir, "Key");
+        storage.Start();
+        EXPECT_TRUE(storage.Put(pad_space("Key 3", length), "latest"));
+
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        std::map<std::string, std::string> values(stats.begin(), stats.end());
+        storage.Stop();
+
+        std::string last = std::string(dir) + "/log." + values["log_segment"];
+        FILE *file = fopen(last.c_str(), "ab");
+        fwrite("garbage", 1, 7, file);
+        fclose(file);
+    }
+
+    std::shared_ptr<ShardedLRU> target(new ShardedLRU(4, 4 * 1000 * length, IndexType::kMap));
+    LogStorage storage(target, dir, "Key");
+    storage.Replay(4);
+
+    std::string res;
+    EXPECT_FALSE(storage.Get("Other", res));
+    EXPECT_TRUE(storage.Get(pad_space("Key 1", length), res));
+    EXPECT_EQ("new", res);
+    EXPECT_TRUE(storage.Get(pad_space("Key 3", length), res));
+    EXPECT_EQ("latest", res);
+    EXPECT_FALSE(storage.Get(pad_space("Key 2", length), res));
+    EXPECT_FALSE(storage.Get(pad_space("Key 995", length), res));
+    EXPECT_TRUE(storage.Get(pad_space("Key 500", length), res));
+    EXPECT_EQ(pad_space("Val 500", length), res);
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ("1", values["log_replay_torn"]);
+
+    std::string cleanup = "rm -rf " + std::string(dir);
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+TEST(StorageTest, LogReplayDeletePrefix) {
+    char dir[] = "afina-log-XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+
+    {
+        std::shared_ptr<ShardedLRU> source(new ShardedLRU(4, 1 << 20, IndexType::kMap));
+        LogStorage storage(source, dir, "user:1:");
+        storage.Start();
+        for (auto &key : {"user:0:a", "user:0:b", "user:1:a", "user:1:b", "user:1:c"}) {
+            EXPECT_TRUE(storage.Put(key, "value"));
+        }
+
+        // Prefix covers both unlogged and logged keys, only the latter ones removed get into the log
+        size_t deleted = 0;
+        EXPECT_TRUE(storage.DeletePrefix("user:", 3, deleted));
+        EXPECT_EQ(3, deleted);
+
+        std::string res;
+        EXPECT_FALSE(storage.Get("user:1:a", res));
+        EXPECT_TRUE(storage.Get("user:1:b", res));
+        storage.Stop();
+    }
+
+    std::shared_ptr<ShardedLRU> target(new ShardedLRU(4, 1 << 20, IndexType::kMap));
+    LogStorage storage(target, dir, "user:1:");
+    storage.Replay(1);
+
+    std::string res;
+    EXPECT_FALSE(storage.Get("user:1:a", res));
+    EXPECT_TRUE(storage.Get("user:1:b", res));
+    EXPECT_TRUE(storage.Get("user:1:c", res));
+
+    std::string cleanup = "rm -rf " + std::string(dir);
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+TEST(StorageTest, TieredDemotePromote) {
+    const size_t length = 20;
+    TieredLRU storage(100 * 2 * length, IndexType::kMap, ".", 1024 * 1024, 4096);
+
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+
+    // Items evicted from memory are still there
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+
+    std::string res;
+    EXPECT_FALSE(storage.PutIfAbsent(pad_space("Key 1", length), "new"));
+    EXPECT_TRUE(storage.Set(pad_space("Key 2", length), "new"));
+    EXPECT_TRUE(storage.Get(pad_space("Key 2", length), res));
+    EXPECT_EQ("new", res);
+    EXPECT_TRUE(storage.Delete(pad_space("Key 3", length)));
+    EXPECT_FALSE(storage.Get(pad_space("Key 3", length), res));
+
+    std::vector<std::string> keys;
+    EXPECT_TRUE(storage.Scan("Key 1", "", 1000, keys));
+    EXPECT_EQ(111, keys.size());
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_NE("0", values["tier_items"]);
+    EXPECT_NE("0", values["tier_promotions"]);
+    EXPECT_EQ("0", values["tier_dropped"]);
+}
+
+TEST(StorageTest, TieredCompaction) {
+    const size_t length = 20;
+    TieredLRU storage(100 * 2 * length, IndexType::kHash, ".", 64 * 4096, 4096);
+    storage.Start();
+
+    // Promotions leave garbage behind, background compaction collects it
+    for (int round = 0; round < 10; round++) {
+        for (long i = 0; i < 1000; ++i) {
+            auto key = pad_space("Key " + std::to_string(i), length);
+            auto val = pad_space("Val " + std::to_string(i), length);
+
+            std::string res;
+            if (round == 0) {
+                EXPECT_TRUE(storage.Put(key, val));
+            } else {
+                EXPECT_TRUE(storage.Get(key, res));
+                EXPECT_TRUE(val == res);
+            }
+        }
+    }
+
+    std::map<std::string, std::string> values;
+    for (int i = 0; i < 100; i++) {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        values = std::map<std::string, std::string>(stats.begin(), stats.end());
+        if (values["tier_compactions"] != "0") {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_NE("0", values["tier_compactions"]);
+    EXPECT_EQ("0", values["tier_dropped"]);
+    EXPECT_LE(std::stoul(values["tier_file_bytes"]), 64 * 4096);
+    storage.Stop();
+
+    // Limit of files size drops the oldest items
+    TieredLRU small(100 * 2 * length, IndexType::kMap, ".", 4 * 4096, 4096);
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(small.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+
+    std::string res;
+    EXPECT_FALSE(small.Get(pad_space("Key 0", length), res));
+    EXPECT_TRUE(small.Get(pad_space("Key 999", length), res));
+}
+
+TEST(StorageTest, TieredPromoteOversized) {
+    TieredLRU storage(1000, IndexType::kMap, ".", 1024 * 1024, 4096);
+    std::string large(600, 'v'), res;
+    EXPECT_TRUE(storage.Put("large", large));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), std::string(100, 'a' + i)));
+    }
+
+    // Value in files doesn't fit into shrunk memory, it is still served on every hit
+    EXPECT_TRUE(storage.Resize(300));
+    for (int i = 0; i < 2; i++) {
+        EXPECT_TRUE(storage.Get("large", res));
+        EXPECT_TRUE(large == res);
+
+        std::vector<std::shared_ptr<const std::string>> chunks;
+        EXPECT_TRUE(storage.GetChunks("large", chunks));
+        ASSERT_EQ(1, chunks.size());
+        EXPECT_TRUE(large == *chunks[0]);
+    }
+
+    EXPECT_TRUE(storage.Get("Key 0", res));
+    EXPECT_EQ(std::string(100, 'a'), res);
+    EXPECT_TRUE(storage.Delete("large"));
+    EXPECT_FALSE(storage.Get("large", res));
+}
+
+TEST(StorageTest, MappedTable) {
+    const std::string path = "afina-storage-test.table";
+    {
+        MappedTableWriter writer(path);
+        for (long i = 0; i < 1000; ++i) {
+            // Zero padded keys are sorted the same way as numbers
+            char key[16];
+            std::snprintf(key, sizeof(key), "Key %04ld", i);
+            writer.Add(key, "Val " + std::to_string(i));
+        }
+        EXPECT_THROW(writer.Add("Key 0000", "Val"), std::runtime_error);
+        writer.Finish();
+    }
+
+    MappedTable table(path);
+    std::string res;
+    EXPECT_TRUE(table.Get("Key 0000", res));
+    EXPECT_EQ("Val 0", res);
+    EXPECT_TRUE(table.Get("Key 0999", res));
+    EXPECT_EQ("Val 999", res);
+    EXPECT_FALSE(table.Get("Key 1000", res));
+    EXPECT_FALSE(table.Get("Key", res));
+
+    // Dataset is read only
+    EXPECT_FALSE(table.Put("Key 0000", "Other"));
+    EXPECT_FALSE(table.Delete("Key 0000"));
+    EXPECT_TRUE(table.Get("Key 0000", res));
+    EXPECT_EQ("Val 0", res);
+
+    std::vector<std::string> keys;
+    EXPECT_TRUE(table.Scan("Key 05", "Key 0510", 3, keys));
+    EXPECT_EQ(std::vector<std::string>({"Key 0511", "Key 0512", "Key 0513"}), keys);
+
+    // Table can be loaded into the regular storage
+    std::size_t items = 0;
+    EXPECT_TRUE(table.Dump([&items](std::size_t, const std::string &, const std::string &) { items++; }));
+    EXPECT_EQ(1000, items);
+
+    // Broken file is rejected
+    std::FILE *file = std::fopen(path.c_str(), "r+");
+    std::fputs("garbage", file);
+    std::fclose(file);
+    EXPECT_THROW(MappedTable broken(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(MappedTable missing(path), std::runtime_error);
+}
+
+TEST(StorageTest, SharedMemoryReattach) {
+    const size_t length = 20;
+    const std::string name = "/afina-storage-test-" + std::to_string(getpid());
+    SharedLRU::Remove(name);
+
+    {
+        SharedLRU storage(name, 1 << 20);
+        EXPECT_FALSE(storage.Attached());
+        for (long i = 0; i < 1000; ++i) {
+            auto key = pad_space("Key " + std::to_string(i), length);
+            EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+        }
+        EXPECT_TRUE(storage.Delete(pad_space("Key 0", length)));
+    }
+
+    // Next owner gets the same content back
+    {
+        SharedLRU storage(name, 1 << 20);
+        EXPECT_TRUE(storage.Attached());
+
+        std::string res;
+        EXPECT_FALSE(storage.Get(pad_space("Key 0", length), res));
+        for (long i = 1; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Get(pad_space("Key " + std::to_string(i), length), res));
+            EXPECT_EQ(pad_space("Val " + std::to_string(i), length), res);
+        }
+    }
+
+    // Owner which didn't detach cleanly leaves nothing to reuse
+    pid_t pid = fork();
+    if (pid == 0) {
+        SharedLRU *crashed = new SharedLRU(name, 1 << 20);
+        _exit(crashed->Attached() ? 0 : 1);
+    }
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+
+    SharedLRU storage(name, 1 << 20);
+    EXPECT_FALSE(storage.Attached());
+    std::string res;
+    EXPECT_FALSE(storage.Get(pad_space("Key 1", length), res));
+
+    // Segment full of items evicts the least recently used ones
+    for (long i = 0; i < 20000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+    EXPECT_FALSE(storage.Get(pad_space("Key 0", length), res));
+    EXPECT_TRUE(storage.Get(pad_space("Key 19999", length), res));
+    EXPECT_FALSE(storage.Put("Key", std::string(1 << 19, 'v')));
+    SharedLRU::Remove(name);
+}
+
+TEST(StorageTest, SharedMemoryDefrag) {
+    const std::string name = "/afina-storage-defrag-" + std::to_string(getpid());
+    SharedLRU::Remove(name);
+
+    // Every other small item stays fresh, so evicted ones leave holes too small for the large items
+    SharedLRU storage(name, 1 << 20);
+    storage.Start();
+    std::string res;
+    for (long i = 0; i < 5000; ++i) {
+        EXPECT_TRUE(storage.Put("Small " + std::to_string(i), std::string(100, 's')));
+    }
+    for (long i = 0; i < 5000; i += 2) {
+        storage.Get("Small " + std::to_string(i), res);
+    }
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("Large " + std::to_string(i), std::string(3000, char('a' + i % 26))));
+    }
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Get("Large " + std::to_string(i), res));
+        EXPECT_EQ(std::string(3000, char('a' + i % 26)), res);
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_GT(std::stoul(values["shm_defrag_steps"]), 0);
+    EXPECT_GT(std::stoul(values["shm_defrag_bytes"]), 0);
+    storage.Stop();
+
+    // Allocator keeps the same history along with the map of the segment
+    stats.clear();
+    storage.AllocatorStats(stats);
+    values = std::map<std::string, std::string>(stats.begin(), stats.end());
+    EXPECT_EQ(std::to_string(1 << 20), values["shm_size"]);
+    EXPECT_EQ(values["shm_defrag_bytes"], std::to_string(std::stoul(values["shm_defrag_bytes"])));
+    EXPECT_GT(std::stoul(values["shm_defrag_steps"]), 0);
+    EXPECT_GT(std::stoul(values["shm_handles_used"]), 100);
+    EXPECT_EQ(1, values.count("shm_region_15_utilization"));
+    SharedLRU::Remove(name);
+}
+
+TEST(StorageTest, SharedMemoryAppend) {
+    const std::string name = "/afina-storage-append-" + std::to_string(getpid());
+    SharedLRU::Remove(name);
+
+    SharedLRU storage(name, 1 << 20, false, true);
+    std::string res, expected;
+    EXPECT_FALSE(storage.Append("Log", "x"));
+    EXPECT_TRUE(storage.Put("Log", ""));
+    EXPECT_TRUE(storage.Put("Other", "value"));
+    for (int i = 0; i < 1000; i++) {
+        std::string record = "record " + std::to_string(i) + ";";
+        EXPECT_TRUE(storage.Append("Log", record));
+        expected += record;
+    }
+    EXPECT_TRUE(storage.Get("Log", res));
+    EXPECT_TRUE(expected == res);
+    EXPECT_TRUE(storage.Get("Other", res));
+    EXPECT_EQ("value", res);
+
+    // Appended item is the freshest, so it pushes the others out rather than itself
+    for (int i = 0; i < 60; i++) {
+        EXPECT_TRUE(storage.Put("Fill " + std::to_string(i), std::string(10000, 'f')));
+    }
+    EXPECT_TRUE(storage.Append("Log", std::string(200 << 10, 'a')));
+    EXPECT_TRUE(storage.Get("Log", res));
+    EXPECT_TRUE(expected + std::string(200 << 10, 'a') == res);
+    EXPECT_FALSE(storage.Append("Log", std::string(100 << 10, 'a')));
+
+    std::size_t bytes = 0;
+    storage.Dump([&bytes](std::size_t, const std::string &key, const std::string &value) {
+        bytes += key.size() + value.size();
+    });
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ(std::to_string(bytes), values["bytes"]);
+    EXPECT_LT(0, std::stoul(values["evictions"]));
+    EXPECT_FALSE(storage.Get("Fill 0", res));
+    SharedLRU::Remove(name);
+}
+
+TEST(StorageTest, LzRoundTrip) {
+    std::string json;
+    for (int i = 0; i < 1000; i++) {
+        json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\", \"tags\": [\"a\", \"b\"]},";
+    }
+
+    std::mt19937 random(42);
+    std::string noise(100000, ' ');
+    for (char &c : noise) {
+        c = random();
+    }
+
+    for (const std::string &value : {std::string(), std::string("abc"), std::string(100000, 'x'), json, noise}) {
+        std::string compressed, restored;
+        Lz::Compress(value.data(), value.size(), compressed);
+        EXPECT_TRUE(Lz::Decompress(compressed.data(), compressed.size(), value.size(), restored));
+        EXPECT_TRUE(value == restored);
+
+        // Broken block is detected rather than read out of bounds
+        restored.clear();
+        EXPECT_FALSE(Lz::Decompress(compressed.data(), compressed.size(), value.size() + 1, restored));
+        if (compressed.size() > 1) {
+            restored.clear();
+            EXPECT_FALSE(Lz::Decompress(compressed.data(), compressed.size() - 1, value.size(), restored));
+        }
+    }
+
+    std::string compressed;
+    Lz::Compress(json.data(), json.size(), compressed);
+    EXPECT_LT(compressed.size(), json.size() / 4);
+}
+
+TEST(StorageTest, CompressedValues) {
+    std::shared_ptr<SimpleLRU> inner(new SimpleLRU(1 << 20));
+    CompressedStorage storage(inner, 1024);
+
+    std::string large, res;
+    for (int i = 0; i < 1000; i++) {
+        large += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\"},";
+    }
+    EXPECT_TRUE(storage.Put("large", large));
+    EXPECT_TRUE(storage.Put("small", "value"));
+    EXPECT_TRUE(storage.Get("large", res));
+    EXPECT_TRUE(large == res);
+    EXPECT_TRUE(storage.Get("small", res));
+    EXPECT_EQ("value", res);
+
+    // Decorated storage keeps compressed data
+    EXPECT_TRUE(inner->Get("large", res));
+    EXPECT_LT(res.size(), large.size() / 4);
+
+    // Dump gives plain values
+    std::map<std::string, std::string> dumped;
+    EXPECT_TRUE(storage.Dump([&dumped](std::size_t, const std::string &key, const std::string &value) {
+        dumped[key] = value;
+    }));
+    EXPECT_TRUE(large == dumped["large"]);
+    EXPECT_EQ("value", dumped["small"]);
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ("1", values["compress_values"]);
+    EXPECT_EQ("2", values["decompress_values"]);
+    EXPECT_GT(std::stod(values["compress_ratio"]), 4.0);
+}
+
+TEST(StorageTest, CompressedConcurrentAppend) {
+    std::shared_ptr<ThreadSafeSimplLRU> inner(new ThreadSafeSimplLRU(16 << 20, IndexType::kHash));
+    CompressedStorage storage(inner, 1024);
+
+    std::string large, res;
+    for (int i = 0; i < 100; i++) {
+        large += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\"},";
+    }
+    EXPECT_TRUE(storage.Put("large", large));
+    EXPECT_FALSE(storage.Append("missing", "data"));
+
+    // Appends go to the decorated storage as is, so none of them get lost
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&storage, t] {
+            for (int i = 0; i < 500; i++) {
+                EXPECT_TRUE(storage.Append("large", std::string(1, 'a' + t)));
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+
+    EXPECT_TRUE(storage.Get("large", res));
+    ASSERT_EQ(large.size() + 2000, res.size());
+    EXPECT_TRUE(res.compare(0, large.size(), large) == 0);
+    for (int t = 0; t < 4; t++) {
+        EXPECT_EQ(500, std::count(res.begin() + large.size(), res.end(), 'a' + t));
+    }
+
+    std::string joined;
+    std::vector<std::shared_ptr<const std::string>> chunks;
+    EXPECT_TRUE(storage.GetChunks("large", chunks));
+    for (auto &chunk : chunks) {
+        joined += *chunk;
+    }
+    EXPECT_TRUE(res == joined);
+
+    EXPECT_TRUE(storage.Put("small", "value"));
+    EXPECT_TRUE(storage.Append("small", "s"));
+    chunks.clear();
+    joined.clear();
+    EXPECT_TRUE(storage.GetChunks("small", chunks));
+    for (auto &chunk : chunks) {
+        joined += *chunk;
+    }
+    EXPECT_EQ("values", joined);
+
+    // Whole value got compressed once
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> values(stats.begin(), stats.end());
+    EXPECT_EQ("1", values["compress_values"]);
+}
+
+TEST(StorageTest, ChunkedAppend) {
+    std::shared_ptr<ThreadSafeSimplLRU> inner(new ThreadSafeSimplLRU(16 << 20, IndexType::kHash));
+    char dir[] = "afina-log-XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+
+    std::string expected(100, 'a');
+    std::vector<std::shared_ptr<const std::string>> held;
+    {
+        LogStorage storage(inner, dir, "", 100);
+        storage.Start();
+        EXPECT_FALSE(storage.Append("log", "data"));
+        EXPECT_TRUE(storage.Put("log", expected));
+
+        std::string piece(10000, ' ');
+        for (int i = 0; i < 200; i++) {
+            std::fill(piece.begin(), piece.end(), 'a' + i % 26);
+            EXPECT_TRUE(storage.Append("log", piece));
+            expected += piece;
+
+            // Chunks handed out never change
+            if (i == 100) {
+                EXPECT_TRUE(storage.GetChunks("log", held));
+            }
+        }
+        storage.Stop();
+    }
+
+    std::vector<std::shared_ptr<const std::string>> chunks;
+    EXPECT_TRUE(inner->GetChunks("log", chunks));
+    EXPECT_GT(chunks.size(), 1);
+
+    std::string joined;
+    for (auto &chunk : chunks) {
+        EXPECT_LE(chunk->size(), ChunkedValue::kChunkSize);
+        joined += *chunk;
+    }
+    EXPECT_TRUE(expected == joined);
+
+    joined.clear();
+    for (auto &chunk : held) {
+        joined += *chunk;
+    }
+    EXPECT_TRUE(expected.compare(0, joined.size(), joined) == 0);
+    EXPECT_EQ(100 + 101 * 10000, joined.size());
+
+    // Log keeps appended data only, replay restores the whole value
+    std::shared_ptr<SimpleLRU> target(new SimpleLRU(16 << 20));
+    LogStorage replayed(target, dir, "", 100);
+    EXPECT_EQ(201, replayed.Replay(1));
+
+    std::string res;
+    EXPECT_TRUE(target->Get("log", res));
+    EXPECT_TRUE(expected == res);
+
+    std::string cleanup = std::string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+TEST(StorageTest, MemoryPressureResize) {
+    char dir[] = "afina-cgroup-XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+    auto write = [&dir](const std::string &file, const std::string &content) {
+        std::ofstream(std::string(dir) + "/" + file) << content << "\n";
+    };
+
+    std::shared_ptr<SimpleLRU> inner(new SimpleLRU(1000 * 1000));
+    AdaptiveStorage storage(inner, 1000 * 1000, dir, 0);
+    std::string value(996, 'v');
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put(std::to_string(1000 + i), value));
+    }
+
+    auto stat = [&storage](const std::string &name) {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        std::map<std::string, std::string> values(stats.begin(), stats.end());
+        return values[name];
+    };
+
+    // Close to the limit: budget shrinks and the oldest items go
+    write("memory.max", "100000000");
+    write("memory.current", "99000000");
+    write("memory.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=0");
+    EXPECT_EQ(100 * 1000, storage.Check());
+    EXPECT_EQ("cgroup", stat("memory_source"));
+    EXPECT_EQ("shrink", stat("memory_last_decision"));
+    EXPECT_EQ("100000", stat("limit_maxbytes"));
+    EXPECT_LE(std::stoul(stat("bytes")), 100 * 1000);
+
+    std::string res;
+    EXPECT_FALSE(storage.Get("1000", res));
+    EXPECT_TRUE(storage.Get("1999", res));
+
+    // Pressure alone shrinks too, but never below the floor
+    write("memory.current", "10000000");
+    write("memory.pressure", "some avg10=25.00 avg60=5.00 avg300=1.00 total=100\nfull avg10=0.00");
+    EXPECT_EQ(100 * 1000, storage.Check());
+    EXPECT_EQ("shrink", stat("memory_last_decision"));
+
+    // Memory is back: budget grows step by step up to the configured size
+    write("memory.max", "max");
+    write("memory.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=100");
+    EXPECT_EQ(200 * 1000, storage.Check());
+    EXPECT_EQ("grow", stat("memory_last_decision"));
+    for (int i = 0; i < 10; i++) {
+        storage.Check();
+    }
+    EXPECT_EQ("1000000", stat("limit_maxbytes"));
+    EXPECT_EQ("hold", stat("memory_last_decision"));
+    EXPECT_EQ("1", stat("memory_shrinks"));
+
+    std::string cleanup = std::string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}